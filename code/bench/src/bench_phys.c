@@ -0,0 +1,205 @@
+#define ZPL_IMPL
+#include "zpl.h"
+#include "systems/physics.h"
+
+ZPL_DIAGNOSTIC_PUSH_WARNLEVEL(0)
+#define CUTE_C2_IMPLEMENTATION
+#include "tinyc2.h"
+ZPL_DIAGNOSTIC_POP
+
+// NOTE(zaklaus): narrow phase microbenchmark
+//
+// Runs the same candidate pairs through tinyc2's c2Collide, the way BodyCollisions used to
+// call it per pair, and through the batched kernels in systems/physics.c. Bodies are packed
+// into a mob horde, the candidates are every pair within reach of each other.
+
+#define BENCH_BLOCK_SIZE 64.0f
+#define BENCH_DEFAULT_BODIES 5000
+#define BENCH_DEFAULT_PAIRS (64 * 1024 * 1024)
+#define BENCH_EPSILON 1e-3f
+
+enum { BENCH_CIRCLE, BENCH_AABB };
+
+typedef struct {
+    char const *name;
+    uint8_t kind_a, kind_b;
+    physics_batch batch;
+    void (*kernel)(physics_batch *batch);
+} bench_case;
+
+typedef struct {
+    uint32_t count;
+    float *x, *y, *hx, *hy, *r;
+} bench_bodies;
+
+static void bench_gen_horde(bench_bodies *b, uint32_t count, float spread) {
+    zpl_random rnd = {0};
+    zpl_random_init(&rnd);
+
+    b->count = count;
+    b->x = zpl_malloc(sizeof(float) * count);
+    b->y = zpl_malloc(sizeof(float) * count);
+    b->hx = zpl_malloc(sizeof(float) * count);
+    b->hy = zpl_malloc(sizeof(float) * count);
+    b->r = zpl_malloc(sizeof(float) * count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        b->x[i] = (float)zpl_random_range_f64(&rnd, 0.0, spread);
+        b->y[i] = (float)zpl_random_range_f64(&rnd, 0.0, spread);
+        b->hx[i] = BENCH_BLOCK_SIZE / 2;
+        b->hy[i] = BENCH_BLOCK_SIZE / 4;
+        b->r[i] = BENCH_BLOCK_SIZE / 4;
+    }
+}
+
+static void bench_push(physics_batch *batch, bench_case const *c, bench_bodies *b, uint32_t i, uint32_t j) {
+    float dx = b->x[j] - b->x[i];
+    float dy = b->y[j] - b->y[i];
+
+    if (c->kind_a == BENCH_AABB && c->kind_b == BENCH_AABB) {
+        physics_batch_push(batch, i, j, dx, dy, b->hx[i] + b->hx[j], b->hy[i] + b->hy[j], 0.0f);
+    } else if (c->kind_a == BENCH_CIRCLE && c->kind_b == BENCH_CIRCLE) {
+        physics_batch_push(batch, i, j, dx, dy, 0.0f, 0.0f, b->r[i] + b->r[j]);
+    } else {
+        physics_batch_push(batch, i, j, dx, dy, b->hx[j], b->hy[j], b->r[i]);
+    }
+}
+
+// NOTE(zaklaus): the previous per-pair path, kept as the baseline
+static c2Manifold bench_ref_collide(bench_case *c, bench_bodies *b, uint32_t i, uint32_t j) {
+    c2AABB box_a = { .min = { b->x[i] - b->hx[i], b->y[i] - b->hy[i] }, .max = { b->x[i] + b->hx[i], b->y[i] + b->hy[i] } };
+    c2AABB box_b = { .min = { b->x[j] - b->hx[j], b->y[j] - b->hy[j] }, .max = { b->x[j] + b->hx[j], b->y[j] + b->hy[j] } };
+    c2Circle circle_a = { .p = { b->x[i], b->y[i] }, .r = b->r[i] };
+    c2Circle circle_b = { .p = { b->x[j], b->y[j] }, .r = b->r[j] };
+
+    const void *shapes_a[] = { &circle_a, &box_a };
+    const void *shapes_b[] = { &circle_b, &box_b };
+
+    c2Manifold m = { 0 };
+    c2Collide(shapes_a[c->kind_a], 0, c->kind_a, shapes_b[c->kind_b], 0, c->kind_b, &m);
+    return m;
+}
+
+static uint32_t bench_verify(bench_case *c, bench_bodies *b) {
+    uint32_t mismatches = 0;
+    c->kernel(&c->batch);
+
+    for (uint32_t k = 0; k < c->batch.count; k++) {
+        c2Manifold m = bench_ref_collide(c, b, c->batch.a[k], c->batch.b[k]);
+        float depth = m.count ? m.depths[0] : 0.0f;
+        float nx = m.count ? m.n.x : 0.0f;
+        float ny = m.count ? m.n.y : 0.0f;
+
+        // NOTE(zaklaus): touching shapes report a zero-depth contact in tinyc2, both resolve to no response
+        if (depth == 0.0f && c->batch.depth[k] == 0.0f) continue;
+
+        if (zpl_abs(depth - c->batch.depth[k]) > BENCH_EPSILON ||
+            zpl_abs(nx - c->batch.nx[k]) > BENCH_EPSILON ||
+            zpl_abs(ny - c->batch.ny[k]) > BENCH_EPSILON) {
+            mismatches++;
+        }
+    }
+
+    return mismatches;
+}
+
+static void bench_case_run(bench_case *c, bench_bodies *b, uint64_t total_pairs) {
+    uint32_t count = c->batch.count;
+    if (!count) return;
+
+    uint64_t iters = zpl_max(1, total_pairs / count);
+    uint32_t mismatches = bench_verify(c, b);
+    uint32_t hits = 0;
+    for (uint32_t k = 0; k < count; k++) hits += c->batch.depth[k] > 0.0f;
+
+    volatile float sink = 0.0f;
+
+    double start = zpl_time_rel();
+    for (uint64_t it = 0; it < iters; it++) {
+        for (uint32_t k = 0; k < count; k++) {
+            c2Manifold m = bench_ref_collide(c, b, c->batch.a[k], c->batch.b[k]);
+            sink += m.count ? m.depths[0] : 0.0f;
+        }
+    }
+    double ref_time = zpl_time_rel() - start;
+
+    start = zpl_time_rel();
+    for (uint64_t it = 0; it < iters; it++) {
+        c->kernel(&c->batch);
+        sink += c->batch.depth[it % count];
+    }
+    double kernel_time = zpl_time_rel() - start;
+
+    // NOTE(zaklaus): packing the batch is part of the new path, measure it separately
+    physics_batch pack = {0};
+    start = zpl_time_rel();
+    for (uint64_t it = 0; it < iters; it++) {
+        physics_batch_clear(&pack);
+        for (uint32_t k = 0; k < count; k++) {
+            bench_push(&pack, c, b, c->batch.a[k], c->batch.b[k]);
+        }
+    }
+    double pack_time = zpl_time_rel() - start;
+    physics_batch_free(&pack);
+    (void)sink;
+
+    double pairs = (double)iters * (double)count;
+    zpl_printf("%-16s %8u %8u %10.2f %10.2f %10.2f %8.2fx %6u\n", c->name, count, hits,
+               ref_time * 1e9 / pairs, kernel_time * 1e9 / pairs, pack_time * 1e9 / pairs,
+               ref_time / zpl_max(kernel_time + pack_time, 1e-9), mismatches);
+}
+
+int main(int argc, char **argv) {
+    zpl_opts opts={0};
+    zpl_opts_init(&opts, zpl_heap(), argv[0]);
+
+    zpl_opts_add(&opts, "?", "help", "the HELP section", ZPL_OPTS_FLAG);
+    zpl_opts_add(&opts, "n", "bodies", "amount of bodies in the horde", ZPL_OPTS_INT);
+    zpl_opts_add(&opts, "p", "pairs", "amount of pairs to process per case and implementation", ZPL_OPTS_INT);
+
+    uint32_t ok = zpl_opts_compile(&opts, argc, argv);
+
+    if (!ok || zpl_opts_has_arg(&opts, "help")) {
+        zpl_opts_print_errors(&opts);
+        zpl_opts_print_help(&opts);
+        return ok ? 0 : -1;
+    }
+
+    uint32_t body_count = (uint32_t)zpl_opts_integer(&opts, "bodies", BENCH_DEFAULT_BODIES);
+    uint64_t total_pairs = (uint64_t)zpl_opts_integer(&opts, "pairs", BENCH_DEFAULT_PAIRS);
+
+    // NOTE(zaklaus): roughly 4 bodies per block, the density of a horde around a player
+    bench_bodies bodies = {0};
+    bench_gen_horde(&bodies, body_count, zpl_sqrt((float)body_count / 4.0f) * BENCH_BLOCK_SIZE);
+
+    bench_case cases[] = {
+        {"aabb_aabb", BENCH_AABB, BENCH_AABB, {0}, physics_collide_aabb_aabb},
+        {"circle_circle", BENCH_CIRCLE, BENCH_CIRCLE, {0}, physics_collide_circle_circle},
+        {"circle_aabb", BENCH_CIRCLE, BENCH_AABB, {0}, physics_collide_circle_aabb},
+    };
+
+    float reach = BENCH_BLOCK_SIZE * 1.5f;
+    for (uint32_t i = 0; i < bodies.count; i++) {
+        for (uint32_t j = i + 1; j < bodies.count; j++) {
+            if (zpl_abs(bodies.x[j] - bodies.x[i]) > reach || zpl_abs(bodies.y[j] - bodies.y[i]) > reach) continue;
+            for (uint32_t c = 0; c < zpl_count_of(cases); c++) {
+                bench_push(&cases[c].batch, &cases[c], &bodies, i, j);
+            }
+        }
+    }
+
+    zpl_printf("%d bodies, simd %s\n", bodies.count, PHYSICS_SIMD ? "on" : "off");
+    zpl_printf("%-16s %8s %8s %10s %10s %10s %9s %6s\n", "case", "pairs", "hits", "c2 ns", "batch ns", "pack ns", "speedup", "diff");
+    for (uint32_t c = 0; c < zpl_count_of(cases); c++) {
+        bench_case_run(&cases[c], &bodies, total_pairs);
+        physics_batch_free(&cases[c].batch);
+    }
+
+    zpl_mfree(bodies.x);
+    zpl_mfree(bodies.y);
+    zpl_mfree(bodies.hx);
+    zpl_mfree(bodies.hy);
+    zpl_mfree(bodies.r);
+    zpl_opts_free(&opts);
+    return 0;
+}
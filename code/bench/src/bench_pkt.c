@@ -0,0 +1,261 @@
+#define ZPL_IMPL
+#define ZPL_HEAP_ANALYSIS
+#include "zpl.h"
+#include "platform/system.h"
+#include "pkt/packet_utils.h"
+#include "world/entity_view.h"
+
+#include "packets/pkt_00_init.h"
+#include "packets/pkt_01_welcome.h"
+#include "packets/pkt_send_keystate.h"
+#include "packets/pkt_switch_viewer.h"
+#include "packets/pkt_send_notif.h"
+#include "packets/pkt_send_code.h"
+
+// NOTE(zaklaus): packet codec microbenchmark
+//
+// Encodes and decodes a representative struct for every message descriptor and reports
+// ns/op, bytes/op and the heap allocations left behind per op. Nothing here touches the
+// window or the network, so it runs headless; --csv switches to machine readable output
+// and a failed round-trip makes the process exit with a non-zero code.
+
+#define BENCH_DEFAULT_ITERS 10000
+#define BENCH_MIN_SECONDS 0.25
+
+typedef size_t bench_encode_proc(pkt_ctx *ctx, void const *msg);
+typedef int32_t bench_decode_proc(pkt_ctx *ctx, uint8_t *data, size_t datalen, void *msg);
+
+typedef struct {
+    char const *name;
+    void *msg;
+    size_t msg_size;
+    bench_encode_proc *encode;
+    bench_decode_proc *decode;
+} bench_case;
+
+#define BENCH_PKT_MESSAGES(X) \
+    X(pkt_00_init, pkt_00_init) \
+    X(pkt_01_welcome, pkt_01_welcome) \
+    X(pkt_send_keystate, pkt_send_keystate) \
+    X(pkt_input_history, pkt_input_history) \
+    X(pkt_switch_viewer, pkt_switch_viewer) \
+    X(pkt_send_notification, pkt_send_notification) \
+    X(pkt_send_code, pkt_send_code)
+
+#define X(name, type) \
+    static size_t bench_encode_##name(pkt_ctx *ctx, void const *msg) { \
+        return name##_encode(ctx, (type const*)msg); \
+    } \
+    static int32_t bench_decode_##name(pkt_ctx *ctx, uint8_t *data, size_t datalen, void *msg) { \
+        pkt_header header = {.data = data, .datalen = (uint32_t)datalen, .ctx = ctx}; \
+        return name##_decode(&header, (type*)msg); \
+    }
+BENCH_PKT_MESSAGES(X)
+#undef X
+
+// NOTE(zaklaus): msgpack variant of the entity view codec, the stream uses the bitstream one
+PKT_CODEC_DECLARE(pkt_entity_view, entity_view);
+
+static size_t bench_encode_entity_view_msgpack(pkt_ctx *ctx, void const *msg) {
+    cw_pack_context pc = {0};
+    cw_pack_context_init(&pc, ctx->buffer, PKT_BUFSIZ, 0);
+    pkt_entity_view_pack(ctx, &pc, (entity_view const*)msg);
+    return pc.current - pc.start;
+}
+
+static int32_t bench_decode_entity_view_msgpack(pkt_ctx *ctx, uint8_t *data, size_t datalen, void *msg) {
+    entity_view *view = (entity_view*)msg;
+    cw_unpack_context uc = {0};
+    cw_unpack_context_init(&uc, data, (unsigned long)datalen, 0);
+    zpl_zero_item(view);
+    int32_t result = pkt_entity_view_unpack(ctx, &uc, view);
+    view->blocks_used = (view->kind == EKIND_CHUNK);
+    return result;
+}
+
+static size_t bench_encode_entity_view(pkt_ctx *ctx, void const *msg) {
+    return entity_view_pack_struct(ctx, ctx->buffer, PKT_BUFSIZ, (entity_view*)msg);
+}
+
+static int32_t bench_decode_entity_view(pkt_ctx *ctx, uint8_t *data, size_t datalen, void *msg) {
+    entity_view *view = (entity_view*)msg;
+    *view = entity_view_unpack_struct(ctx, data, datalen);
+
+    // NOTE(zaklaus): blocks_used picks the chunk layout but isn't sent, chunks always carry their blocks
+    view->blocks_used = (view->kind == EKIND_CHUNK);
+    return 0;
+}
+
+// NOTE(zaklaus): sample data
+static pkt_00_init sample_00_init = {.view_id = 3};
+static pkt_01_welcome sample_01_welcome = {.seed = 302097, .ent_id = 1287, .chunk_size = 16, .world_size = 20};
+static pkt_switch_viewer sample_switch_viewer = {.view_id = 1};
+static pkt_send_keystate sample_keystate;
+static pkt_input_history sample_input_history;
+static pkt_send_notification sample_notification;
+static pkt_send_code sample_code;
+static entity_view sample_player_view;
+static entity_view sample_chunk_view;
+static entity_view sample_item_view;
+
+static void bench_fill_samples(void) {
+    sample_keystate = (pkt_send_keystate){
+        .x = 0.7f, .y = -0.7f, .mx = 1250.5f, .my = 980.25f,
+        .use = 1, .sprint = 1, .selected_item = 2,
+    };
+    sample_keystate.placement_num = 4;
+    for (uint8_t i = 0; i < sample_keystate.placement_num; i++) {
+        sample_keystate.placements[i] = (item_placement){.x = 32.0f * i, .y = 16.0f, .rot = 0.0f, .kind = 5};
+    }
+
+    // NOTE(zaklaus): full history, as sent once the client has been running for a few frames
+    for (uint8_t i = 0; i < PKT_INPUT_REDUNDANCY; i++) {
+        pkt_input_frame frame = {.keys = sample_keystate, .bx = 1248.0f + 16.0f * i, .by = 976.0f};
+        frame.keys.mx += 4.0f * i;
+        pkt_input_history_push(&sample_input_history, &frame);
+    }
+
+    zpl_strncpy(sample_notification.title, "Someone died!", sizeof(sample_notification.title));
+    zpl_strncpy(sample_notification.text, "Player 1287 has died!", sizeof(sample_notification.text));
+
+    sample_code = (pkt_send_code){.code = 1, .params = {4, 8, 15, 16}};
+    zpl_strncpy(sample_code.data, "spawn_wave", sizeof(sample_code.data));
+
+    sample_player_view = (entity_view){
+        .kind = EKIND_PLAYER, .x = 512.0f, .y = 384.0f, .vx = 12.0f, .vy = -3.5f,
+        .hp = 80.0f, .max_hp = 100.0f, .has_items = true, .selected_item = 1,
+        .durability = 1.0f,
+    };
+    for (uint16_t i = 0; i < 5; i++) {
+        sample_player_view.items[i] = (Item){.kind = (uint16_t)(i + 1), .quantity = i * 7u + 1u, .durability = 1.0f};
+    }
+
+    sample_chunk_view = (entity_view){.kind = EKIND_CHUNK, .x = 3.0f, .y = 7.0f, .chk_id = 143, .blocks_used = 1};
+    for (uint32_t i = 0; i < zpl_count_of(sample_chunk_view.blocks); i++) {
+        uint32_t x = i % 16, y = i / 16;
+        sample_chunk_view.blocks[i] = (block_id)((x + y) / 6 + 1);
+        sample_chunk_view.outer_blocks[i] = (block_id)((x * 7 + y * 13) % 29 == 0 ? 5 : 0);
+    }
+
+    sample_item_view = (entity_view){.kind = EKIND_ITEM, .x = 640.0f, .y = 200.0f, .asset = 12, .quantity = 3, .durability = 0.5f};
+}
+
+static bench_case bench_cases[] = {
+    {"pkt_00_init", &sample_00_init, sizeof(pkt_00_init), bench_encode_pkt_00_init, bench_decode_pkt_00_init},
+    {"pkt_01_welcome", &sample_01_welcome, sizeof(pkt_01_welcome), bench_encode_pkt_01_welcome, bench_decode_pkt_01_welcome},
+    {"pkt_send_keystate", &sample_keystate, sizeof(pkt_send_keystate), bench_encode_pkt_send_keystate, bench_decode_pkt_send_keystate},
+    {"pkt_input_history", &sample_input_history, sizeof(pkt_input_history), bench_encode_pkt_input_history, bench_decode_pkt_input_history},
+    {"pkt_switch_viewer", &sample_switch_viewer, sizeof(pkt_switch_viewer), bench_encode_pkt_switch_viewer, bench_decode_pkt_switch_viewer},
+    {"pkt_send_notification", &sample_notification, sizeof(pkt_send_notification), bench_encode_pkt_send_notification, bench_decode_pkt_send_notification},
+    {"pkt_send_code", &sample_code, sizeof(pkt_send_code), bench_encode_pkt_send_code, bench_decode_pkt_send_code},
+    {"entity_view_player", &sample_player_view, sizeof(entity_view), bench_encode_entity_view, bench_decode_entity_view},
+    {"entity_view_chunk", &sample_chunk_view, sizeof(entity_view), bench_encode_entity_view, bench_decode_entity_view},
+    {"entity_view_item", &sample_item_view, sizeof(entity_view), bench_encode_entity_view, bench_decode_entity_view},
+    {"entity_view_player_mp", &sample_player_view, sizeof(entity_view), bench_encode_entity_view_msgpack, bench_decode_entity_view_msgpack},
+    {"entity_view_chunk_mp", &sample_chunk_view, sizeof(entity_view), bench_encode_entity_view_msgpack, bench_decode_entity_view_msgpack},
+    {"entity_view_item_mp", &sample_item_view, sizeof(entity_view), bench_encode_entity_view_msgpack, bench_decode_entity_view_msgpack},
+};
+
+typedef struct {
+    size_t bytes;
+    double pack_ns;
+    double unpack_ns;
+    double pack_allocs;
+    double unpack_allocs;
+} bench_result;
+
+// NOTE(zaklaus): zpl_time_rel has millisecond resolution, so batches are repeated until enough time passed
+static double bench_measure(bench_case *c, pkt_ctx *ctx, uint8_t *wire, size_t bytes, void *decoded, bool is_pack, uint64_t iters, double *allocs) {
+    zpl_isize start_allocs = zpl_heap_stats_alloc_count();
+    uint64_t total = 0;
+    double start = zpl_time_rel();
+    double elapsed = 0.0;
+    do {
+        for (uint64_t i = 0; i < iters; i++) {
+            if (is_pack) c->encode(ctx, c->msg);
+            else c->decode(ctx, wire, bytes, decoded);
+        }
+        total += iters;
+        elapsed = zpl_time_rel() - start;
+    } while (elapsed < BENCH_MIN_SECONDS);
+
+    *allocs = (double)(zpl_heap_stats_alloc_count() - start_allocs) / (double)total;
+    return elapsed * 1e9 / (double)total;
+}
+
+static bool bench_case_run(bench_case *c, pkt_ctx *ctx, uint64_t iters, bench_result *res) {
+    uint8_t *wire = zpl_malloc(PKT_BUFSIZ);
+    void *decoded = zpl_malloc(c->msg_size);
+    bool ok = true;
+
+    // NOTE(zaklaus): round-trip check, the decoded struct has to encode back to the same bytes
+    size_t bytes = c->encode(ctx, c->msg);
+    zpl_memcopy(wire, ctx->buffer, bytes);
+    zpl_memset(decoded, 0, c->msg_size);
+    if (c->decode(ctx, wire, bytes, decoded) < 0 || c->encode(ctx, decoded) != bytes || zpl_memcompare(wire, ctx->buffer, bytes)) {
+        ok = false;
+    }
+
+    res->pack_ns = bench_measure(c, ctx, wire, bytes, decoded, true, iters, &res->pack_allocs);
+    res->unpack_ns = bench_measure(c, ctx, wire, bytes, decoded, false, iters, &res->unpack_allocs);
+    res->bytes = bytes;
+
+    zpl_mfree(wire);
+    zpl_mfree(decoded);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    zpl_heap_stats_init();
+
+    zpl_opts opts={0};
+    zpl_opts_init(&opts, zpl_heap(), argv[0]);
+
+    zpl_opts_add(&opts, "?", "help", "the HELP section", ZPL_OPTS_FLAG);
+    zpl_opts_add(&opts, "n", "iters", "iterations per timing batch", ZPL_OPTS_INT);
+    zpl_opts_add(&opts, "c", "csv", "print results as CSV", ZPL_OPTS_FLAG);
+    zpl_opts_add(&opts, "f", "filter", "only run messages containing this string", ZPL_OPTS_STRING);
+
+    uint32_t ok = zpl_opts_compile(&opts, argc, argv);
+
+    if (!ok || zpl_opts_has_arg(&opts, "help")) {
+        zpl_opts_print_errors(&opts);
+        zpl_opts_print_help(&opts);
+        return ok ? 0 : -1;
+    }
+
+    uint64_t iters = (uint64_t)zpl_max(1, zpl_opts_integer(&opts, "iters", BENCH_DEFAULT_ITERS));
+    int8_t is_csv = zpl_opts_has_arg(&opts, "csv");
+    zpl_string filter = zpl_opts_string(&opts, "filter", NULL);
+
+    bench_fill_samples();
+    pkt_ctx *ctx = pkt_ctx_create();
+    int32_t failures = 0;
+
+    if (is_csv) {
+        zpl_printf("message,struct_bytes,wire_bytes,pack_ns,unpack_ns,pack_allocs,unpack_allocs,ok\n");
+    } else {
+        zpl_printf("%-24s %8s %8s %10s %10s %8s %8s\n", "message", "struct", "wire", "pack ns", "unpack ns", "pk alloc", "up alloc");
+    }
+
+    for (uint32_t i = 0; i < zpl_count_of(bench_cases); i++) {
+        bench_case *c = &bench_cases[i];
+        if (filter && !strstr(c->name, filter)) continue;
+
+        bench_result res = {0};
+        bool passed = bench_case_run(c, ctx, iters, &res);
+        if (!passed) failures++;
+
+        if (is_csv) {
+            zpl_printf("%s,%zu,%zu,%.2f,%.2f,%.4f,%.4f,%d\n", c->name, c->msg_size, res.bytes,
+                       res.pack_ns, res.unpack_ns, res.pack_allocs, res.unpack_allocs, passed);
+        } else {
+            zpl_printf("%-24s %8zu %8zu %10.2f %10.2f %8.4f %8.4f%s\n", c->name, c->msg_size, res.bytes,
+                       res.pack_ns, res.unpack_ns, res.pack_allocs, res.unpack_allocs, passed ? "" : "  round-trip failed");
+        }
+    }
+
+    pkt_ctx_destroy(ctx);
+    zpl_opts_free(&opts);
+    return failures ? 1 : 0;
+}
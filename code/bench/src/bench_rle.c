@@ -0,0 +1,179 @@
+#define ZPL_IMPL
+#include "zpl.h"
+#include "platform/system.h"
+#include "utils/compress.h"
+#include "world/perlin.h"
+#include "world/entity_view.h"
+
+// NOTE(zaklaus): RLE codec microbenchmark
+//
+// Compares utils/compress.c against the original byte-at-a-time codec on payloads
+// shaped like the PKT_ARRAY fields we actually send: chunk block layers, inventories
+// and craftable lists, plus a noisy and an oversized buffer for the edge cases.
+
+#define BENCH_SEED 302097
+#define BENCH_CHUNK_SIZE 16
+#define BENCH_BIG_SIZE (256 * 1024)
+#define BENCH_DEFAULT_BYTES (256 * 1024 * 1024)
+
+typedef int32_t bench_codec_proc(void const *data, uint32_t size, uint8_t *dest, uint32_t dest_size);
+
+// NOTE(zaklaus): the previous codec, kept as the baseline
+static int32_t ref_compress_rle(void const *data, uint32_t size, uint8_t *dest, uint32_t dest_size) {
+    (void)dest_size;
+    if (size < 1) return 0;
+    uint32_t total_size = 0;
+    uint8_t const *buf = (uint8_t const*)data;
+    uint8_t byte = buf[0];
+    uint16_t occurences = 1;
+    for (uint32_t i = 1; i <= size; i += 1){
+        if (i == size || buf[i] != byte) {
+            memcpy(dest, &occurences, 2); dest += 2;
+            *dest++ = byte;
+            if (i < size) byte = buf[i];
+            occurences = 1;
+            total_size += 3;
+        }
+        else occurences++;
+    }
+    return (int32_t)total_size;
+}
+
+static int32_t ref_decompress_rle(void const *data, uint32_t size, uint8_t *dest, uint32_t dest_size) {
+    (void)dest_size;
+    uint32_t total_size = 0;
+    uint8_t const *buf = (uint8_t const*)data;
+    for (uint32_t i = 0; i < size; i += 3){
+        uint16_t len;
+        memcpy(&len, &buf[i], 2);
+        for (uint16_t j = 0; j < len; j += 1){
+            *dest++ = buf[i+2];
+            total_size++;
+        }
+    }
+    return (int32_t)total_size;
+}
+
+typedef struct {
+    char const *name;
+    uint8_t *data;
+    uint32_t size;
+} bench_payload;
+
+static void bench_gen_chunk(block_id *blocks, block_id *outer_blocks, int32_t cx, int32_t cy) {
+    for (int32_t y = 0; y < BENCH_CHUNK_SIZE; y++) {
+        for (int32_t x = 0; x < BENCH_CHUNK_SIZE; x++) {
+            double wx = (double)(cx * BENCH_CHUNK_SIZE + x);
+            double wy = (double)(cy * BENCH_CHUNK_SIZE + y);
+            double h = perlin_fbm(BENCH_SEED, wx, wy, 0.05, 4);
+            int32_t i = y * BENCH_CHUNK_SIZE + x;
+            blocks[i] = (block_id)(h < 0.35 ? 1 : h < 0.45 ? 2 : h < 0.7 ? 3 : 4);
+            outer_blocks[i] = (block_id)((h > 0.55 && h < 0.6) ? 5 : 0);
+        }
+    }
+}
+
+static void bench_gen_inventory(Item *items, uint32_t count, uint32_t filled) {
+    zpl_memset(items, 0, sizeof(Item) * count);
+    for (uint32_t i = 0; i < filled && i < count; i++) {
+        items[i].kind = (uint16_t)(i + 1);
+        items[i].quantity = (uint32_t)(i * 7 + 1);
+        items[i].durability = 1.0f;
+    }
+}
+
+static double bench_run(bench_codec_proc *proc, uint8_t const *src, uint32_t size, uint8_t *dest, uint32_t dest_size, uint64_t iters) {
+    double start = zpl_time_rel();
+    for (uint64_t i = 0; i < iters; i++) {
+        proc(src, size, dest, dest_size);
+    }
+    return zpl_time_rel() - start;
+}
+
+static void bench_payload_run(bench_payload *p, uint64_t total_bytes) {
+    uint32_t bound = COMPRESS_RLE_BOUND(p->size);
+    uint8_t *packed = zpl_malloc(bound);
+    uint8_t *unpacked = zpl_malloc(p->size);
+    uint64_t iters = zpl_max(1, total_bytes / p->size);
+
+    struct {
+        char const *name;
+        bench_codec_proc *pack;
+        bench_codec_proc *unpack;
+    } codecs[] = {
+        {"ref", ref_compress_rle, ref_decompress_rle},
+        {"new", compress_rle, decompress_rle},
+    };
+
+    for (uint32_t c = 0; c < zpl_count_of(codecs); c++) {
+        int32_t packed_size = codecs[c].pack(p->data, p->size, packed, bound);
+        int32_t unpacked_size = codecs[c].unpack(packed, (uint32_t)packed_size, unpacked, p->size);
+
+        // NOTE(zaklaus): the reference codec wraps runs past 65535, so it fails on the oversized payload
+        if (unpacked_size != (int32_t)p->size || zpl_memcompare(unpacked, p->data, p->size)) {
+            zpl_printf("%-16s %-4s %10u %10d %8s %10s %10s  round-trip failed\n", p->name, codecs[c].name, p->size, packed_size, "-", "-", "-");
+            continue;
+        }
+
+        double pack_time = bench_run(codecs[c].pack, p->data, p->size, packed, bound, iters);
+        double unpack_time = bench_run(codecs[c].unpack, packed, (uint32_t)packed_size, unpacked, p->size, iters);
+        double gb = (double)iters * (double)p->size / 1e9;
+
+        zpl_printf("%-16s %-4s %10u %10d %8.3f %10.3f %10.3f\n", p->name, codecs[c].name, p->size, packed_size,
+                   (double)packed_size / (double)p->size, gb / pack_time, gb / unpack_time);
+    }
+
+    zpl_mfree(packed);
+    zpl_mfree(unpacked);
+}
+
+int main(int argc, char **argv) {
+    zpl_opts opts={0};
+    zpl_opts_init(&opts, zpl_heap(), argv[0]);
+
+    zpl_opts_add(&opts, "?", "help", "the HELP section", ZPL_OPTS_FLAG);
+    zpl_opts_add(&opts, "b", "bytes", "amount of bytes to process per payload and codec", ZPL_OPTS_INT);
+
+    uint32_t ok = zpl_opts_compile(&opts, argc, argv);
+
+    if (!ok || zpl_opts_has_arg(&opts, "help")) {
+        zpl_opts_print_errors(&opts);
+        zpl_opts_print_help(&opts);
+        return ok ? 0 : -1;
+    }
+
+    uint64_t total_bytes = (uint64_t)zpl_opts_integer(&opts, "bytes", BENCH_DEFAULT_BYTES);
+
+    entity_view view = {0};
+    bench_gen_chunk(view.blocks, view.outer_blocks, 3, 7);
+    bench_gen_inventory(view.items, ITEMS_INVENTORY_SIZE, 5);
+    bench_gen_inventory(view.storage_items, ITEMS_CONTAINER_SIZE, 2);
+    for (uint32_t i = 0; i < 6; i++) view.craftables[i] = (uint16_t)(i + 1);
+
+    uint8_t *noise = zpl_malloc(BENCH_BIG_SIZE);
+    uint8_t *big = zpl_malloc(BENCH_BIG_SIZE);
+    zpl_random rnd = {0};
+    zpl_random_init(&rnd);
+    for (uint32_t i = 0; i < BENCH_BIG_SIZE; i++) noise[i] = (uint8_t)zpl_random_gen_u32(&rnd);
+    zpl_memset(big, 0, BENCH_BIG_SIZE);
+
+    bench_payload payloads[] = {
+        {"chunk_blocks", (uint8_t*)view.blocks, sizeof(view.blocks)},
+        {"chunk_outer", (uint8_t*)view.outer_blocks, sizeof(view.outer_blocks)},
+        {"inventory", (uint8_t*)view.items, sizeof(view.items)},
+        {"storage", (uint8_t*)view.storage_items, sizeof(view.storage_items)},
+        {"craftables", (uint8_t*)view.craftables, sizeof(view.craftables)},
+        {"noise", noise, BENCH_BIG_SIZE},
+        {"zeroes_256k", big, BENCH_BIG_SIZE},
+    };
+
+    zpl_printf("%-16s %-4s %10s %10s %8s %10s %10s\n", "payload", "impl", "raw", "packed", "ratio", "pack GB/s", "unpack GB/s");
+    for (uint32_t i = 0; i < zpl_count_of(payloads); i++) {
+        bench_payload_run(&payloads[i], total_bytes);
+    }
+
+    zpl_mfree(noise);
+    zpl_mfree(big);
+    zpl_opts_free(&opts);
+    return 0;
+}
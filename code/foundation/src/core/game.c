@@ -28,9 +28,30 @@ ZPL_DIAGNOSTIC_PUSH_WARNLEVEL(0)
 #include "raylib-nuklear.h"
 ZPL_DIAGNOSTIC_POP
 
+// NOTE(zaklaus): single-player viewers read entity views straight from the server's snapshot,
+// set to 0 to push them through the packet codec like remote clients do
+#ifndef ECO2D_SP_DIRECT_TRANSPORT
+#define ECO2D_SP_DIRECT_TRANSPORT 1
+#endif
+
 static uint8_t game_mode;
 static uint8_t game_should_close;
 
+// NOTE(zaklaus): neither the dedicated server nor the bots open a window
+#define GAME_HAS_WINDOW() (game_mode != GAMEKIND_HEADLESS && game_mode != GAMEKIND_BOTS)
+
+// NOTE(zaklaus): dedicated server frame times, reported along with the delta
+#define GAME_TICK_BUCKETS 8
+
+static float game_tick_limits[GAME_TICK_BUCKETS - 1] = { 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 33.0f, 66.0f };
+
+static struct {
+    uint64_t count;
+    uint64_t hist[GAME_TICK_BUCKETS];
+    double sum;
+    float max;
+} game_ticks = {0};
+
 static world_view *world_viewers;
 static world_view *active_viewer;
 
@@ -40,6 +61,7 @@ static WORLD_PKT_READER(pkt_reader) {
     pkt_header header = {0};
     uint32_t ok = pkt_header_decode(&header, data, datalen);
     header.udata = udata;
+    header.ctx = pkt_ctx_local();
     
     if (ok && header.ok) {
         return pkt_handlers[header.id].handler(&header) >= 0;
@@ -54,7 +76,23 @@ static WORLD_PKT_WRITER(sp_pkt_writer) {
     return world_read(pkt->data, pkt->datalen, 0);
 }
 
+static WORLD_PKT_ALLOC(mp_pkt_alloc) {
+    if (size == 0) {
+        network_msg_free(pkt->packet);
+        pkt->packet = NULL;
+        return NULL;
+    }
+
+    uint8_t *data = NULL;
+    pkt->packet = network_msg_alloc(size, pkt->is_reliable, &data);
+    return data;
+}
+
 static WORLD_PKT_WRITER(mp_pkt_writer) {
+    if (pkt->packet) {
+        return network_msg_send_packet(udata, pkt->packet, pkt->datalen, pkt->channel_id);
+    }
+
     if (pkt->is_reliable) {
         return network_msg_send(udata, pkt->data, pkt->datalen, pkt->channel_id);
     }
@@ -65,6 +103,10 @@ static WORLD_PKT_WRITER(mp_pkt_writer) {
 
 static WORLD_PKT_WRITER(mp_cli_pkt_writer) {
     (void)udata;
+    if (pkt->packet) {
+        return network_msg_send_packet(0, pkt->packet, pkt->datalen, pkt->channel_id);
+    }
+
     if (pkt->is_reliable) {
         return network_msg_send(0, pkt->data, pkt->datalen, pkt->channel_id);
     }
@@ -116,7 +158,7 @@ entity_view *game_world_view_active_get_entity(uint64_t ent_id) {
 void game_world_view_set_active(world_view *view) {
     active_viewer = view;
     camera_set_follow(view->owner_id);
-    pkt_switch_viewer_send(view->view_id);
+    pkt_switch_viewer_send(pkt_ctx_local(), view->view_id);
 }
 
 size_t game_world_view_count(void) {
@@ -153,7 +195,7 @@ void game_setup(const char *ip, uint16_t port, game_kind play_mode, uint32_t num
         host_ip = ip;
     }
     
-    if (game_mode != GAMEKIND_HEADLESS) {
+    if (GAME_HAS_WINDOW()) {
         platform_init();
         
         world_viewers_init(num_viewers);
@@ -168,17 +210,30 @@ void game_setup(const char *ip, uint16_t port, game_kind play_mode, uint32_t num
         network_init();
     }
     
+    // NOTE(zaklaus): bots keep their own connections and never touch the world, see network_bots_start
+    if (game_mode == GAMEKIND_BOTS) {
+        return;
+    }
+    
     if (game_mode == GAMEKIND_CLIENT) {
         world_setup_pkt_handlers(pkt_reader, mp_cli_pkt_writer);
+        world_setup_pkt_alloc(mp_pkt_alloc);
         network_client_connect(host_ip, host_port);
     } else {
         stdcpp_set_os_api();
         world_setup_pkt_handlers(pkt_reader, game_mode == GAMEKIND_SINGLE ? sp_pkt_writer : mp_pkt_writer);
+        world_setup_pkt_alloc(game_mode == GAMEKIND_SINGLE ? NULL : mp_pkt_alloc);
         world_init(seed, chunk_size, chunk_amount);
+#if ECO2D_SP_DIRECT_TRANSPORT
+        world_setup_direct_transport(game_mode == GAMEKIND_SINGLE);
+#endif
+        // NOTE(zaklaus): local viewers share the server's ecs world and keep using real entity ids
+        world_setup_entity_handles(game_mode != GAMEKIND_SINGLE);
+        world_setup_chunk_quota(game_mode != GAMEKIND_SINGLE);
         if (is_dash_enabled) flecs_dash_init();
         
         if (game_mode == GAMEKIND_HEADLESS) {
-            network_server_start(0, 27000);
+            network_server_start(0, host_port);
             //ecs_set_target_fps(world_ecs(), 60);
         }
     }
@@ -187,7 +242,7 @@ void game_setup(const char *ip, uint16_t port, game_kind play_mode, uint32_t num
     
     if (game_mode == GAMEKIND_SINGLE) {
         for (uint32_t i = 0; i < num_viewers; i++) {
-            pkt_00_init_send(i);
+            pkt_00_init_send(pkt_ctx_local(), i);
         }
     }
 }
@@ -201,6 +256,8 @@ void game_shutdown() {
     
     if (game_mode == GAMEKIND_CLIENT) {
         network_client_disconnect();
+    } else if (game_mode == GAMEKIND_BOTS) {
+        network_bots_stop();
     } else {
         world_destroy();
         
@@ -213,18 +270,21 @@ void game_shutdown() {
         network_destroy();
     }
     
-    if (game_mode != GAMEKIND_HEADLESS) {
+    if (GAME_HAS_WINDOW()) {
         world_viewers_destroy();
         
         // TODO(zaklaus): crashes on exit
         //platform_shutdown();
 		UnloadNuklear(game_ui);
 	}
+    
+    // NOTE(zaklaus): world_destroy joined the worker threads, nobody builds packets anymore
+    pkt_ctx_local_destroy_all();
 }
 
 uint8_t game_is_running() {
     uint8_t is_running = !game_should_close;
-    if (game_mode != GAMEKIND_HEADLESS) {
+    if (GAME_HAS_WINDOW()) {
         is_running = platform_is_running();
     }
     return is_running;
@@ -235,27 +295,62 @@ game_kind game_get_kind(void) {
 }
 
 void game_core_input() {
-    if (game_mode != GAMEKIND_HEADLESS) {
+    if (GAME_HAS_WINDOW()) {
         platform_input();
 		UpdateNuklear(game_ui);
     }
 }
 
+static void game_tick_record(float tick_ms) {
+    game_ticks.count += 1;
+    game_ticks.sum += tick_ms;
+    game_ticks.max = zpl_max(game_ticks.max, tick_ms);
+
+    uint32_t bucket = 0;
+    while (bucket < GAME_TICK_BUCKETS - 1 && tick_ms >= game_tick_limits[bucket]) {
+        bucket += 1;
+    }
+    game_ticks.hist[bucket] += 1;
+}
+
+static void game_tick_report(void) {
+    if (!game_ticks.count) return;
+
+    zpl_printf("server tick: avg %.2f ms, max %.2f ms over %llu ticks,", game_ticks.sum / game_ticks.count, game_ticks.max, (unsigned long long)game_ticks.count);
+    for (uint32_t i = 0; i < GAME_TICK_BUCKETS; i += 1) {
+        if (i < GAME_TICK_BUCKETS - 1) {
+            zpl_printf(" <%.0fms: %llu", game_tick_limits[i], (unsigned long long)game_ticks.hist[i]);
+        } else {
+            zpl_printf(" >=%.0fms: %llu", game_tick_limits[i - 1], (unsigned long long)game_ticks.hist[i]);
+        }
+    }
+    zpl_printf("\n");
+}
+
 void game_core_update() {
     static double last_update = 0.0f;
     if (game_mode == GAMEKIND_CLIENT) {
         network_client_tick();
     }
+    else if (game_mode == GAMEKIND_BOTS) {
+        network_bots_tick();
+        
+        // NOTE(zaklaus): leave the cpu to the server we are measuring
+        zpl_sleep_ms(1);
+    }
     else {
+        double tick_start = zpl_time_rel();
         world_update();
         
         if (game_mode == GAMEKIND_HEADLESS) {
             network_server_tick();
+            game_tick_record((float)((zpl_time_rel() - tick_start)*1000.0));
             
             static float ms_report = 2.5f;
             if (ms_report < get_cached_time()) {
                 ms_report = get_cached_time() + 5.f;
-                zpl_printf("delta: %f ms.\n", (get_cached_time() - last_update)*1000.0f);
+                zpl_printf("delta: %f ms, dropped sim steps: %llu.\n", (get_cached_time() - last_update)*1000.0f, (unsigned long long)world_sim_dropped_steps());
+                game_tick_report();
             }
         }
     }
@@ -264,7 +359,7 @@ void game_core_update() {
 }
 
 void game_core_render() {
-    if (game_mode != GAMEKIND_HEADLESS) {
+    if (GAME_HAS_WINDOW()) {
         platform_render();
     }
 }
@@ -273,21 +368,17 @@ void game_draw_ui() {
 	DrawNuklear(game_ui);
 }
 
-void game_action_send_keystate(game_keystate_data *data) {
-    pkt_send_keystate_send(active_viewer->view_id, data);
+void game_action_send_keystate(game_keystate_data *data, float bx, float by) {
+    pkt_send_keystate_send(pkt_ctx_local(), active_viewer->view_id, data, bx, by);
 }
 
-void game_action_send_blockpos(float mx, float my) {
-    pkt_send_blockpos data = {
-        .mx = mx,
-        .my = my
-    };
-    pkt_send_blockpos_send(active_viewer->view_id, &data);
+void game_action_resend_keystate(void) {
+    pkt_send_keystate_resend(pkt_ctx_local(), active_viewer->view_id);
 }
 
 void game_request_close() {
     game_should_close = true;
-    if (game_mode != GAMEKIND_HEADLESS) {
+    if (GAME_HAS_WINDOW()) {
         platform_request_close();
     }
 }
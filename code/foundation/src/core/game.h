@@ -8,6 +8,7 @@ typedef enum {
     GAMEKIND_SINGLE,
     GAMEKIND_CLIENT,
     GAMEKIND_HEADLESS,
+    GAMEKIND_BOTS, // NOTE(zaklaus): windowless client process driving network bots against a server
     FORCE_GAMEKIND_UINT8 = UINT8_MAX
 } game_kind;
 
@@ -51,5 +52,5 @@ entity_view *game_world_view_active_get_entity(uint64_t ent_id);
 void game_world_view_render_world(void);
 
 //~ NOTE(zaklaus): viewer -> host actions
-void game_action_send_keystate(game_keystate_data *data);
-void game_action_send_blockpos(float mx, float my);
+void game_action_send_keystate(game_keystate_data *data, float bx, float by);
+void game_action_resend_keystate(void);
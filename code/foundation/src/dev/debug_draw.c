@@ -1,3 +1,4 @@
+#include "zpl.h"
 #include "dev/debug_draw.h"
 #include "core/game.h"
 
@@ -25,11 +26,18 @@ bool debug_draw_state(void) {
     return draw_is_enabled;
 }
 
+// NOTE(zaklaus): systems running on worker threads push into the queue as well
+static zpl_atomic32 draw_lock = {0};
+
 static inline void debug_push_entry(debug_draw_entry entry) {
     if (!draw_is_enabled) return;
     if (game_get_kind() == GAMEKIND_HEADLESS) return;
+    while (zpl_atomic32_compare_exchange(&draw_lock, 0, 1) != 0) {
+        zpl_yield_thread();
+    }
     ZPL_ASSERT(draw_queue.num_entries < DEBUG_DRAW_MAX_ENTRIES);
     draw_queue.entries[draw_queue.num_entries++] = entry;
+    zpl_atomic32_store(&draw_lock, 0);
 }
 
 void debug_push_line(debug_v2 a, debug_v2 b, int32_t color) {
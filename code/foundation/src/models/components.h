@@ -33,6 +33,13 @@ typedef Vector2D Velocity;
 typedef struct { char _unused; } InAir;
 typedef struct { char _unused; } TriggerOnly;
 
+// NOTE(zaklaus): bodies at rest are tagged as Sleeping and skipped by physics until woken up
+typedef struct { char _unused; } Sleeping;
+
+typedef struct {
+	uint16_t still_ticks;
+} SleepTimer;
+
 typedef struct {
 	float angle;
 } Rotation;
@@ -94,6 +101,12 @@ typedef struct {
     uintptr_t peer;
     uint16_t view_id;
     uint8_t active;
+
+    // NOTE(zaklaus): sequence of the last input frame we applied, input arrives redundantly
+    uint32_t input_seq;
+
+    // NOTE(zaklaus): last librg update size per tracker layer, sizes the next packet
+    uint32_t stream_size[3];
 } ClientInfo;
 
 typedef struct {
@@ -264,6 +277,7 @@ typedef struct {
 typedef struct {
     uint8_t damage;
     float origin_x, origin_y;
+    float last_x, last_y; // where the last hit test left off
     ecs_entity_t owner;
 } WeaponProjectile;
 
@@ -274,6 +288,8 @@ typedef struct {
 	X(InAir)\
 	X(Rotation)\
 	X(TriggerOnly)\
+	X(Sleeping)\
+	X(SleepTimer)\
 	X(PhysicsBody)\
 	X(Chunk)\
 	X(Drawable)\
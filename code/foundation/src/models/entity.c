@@ -3,6 +3,7 @@
 #include "flecs.h"
 #include "librg.h"
 #include "world/world.h"
+#include "world/streamer.h"
 
 #include "models/components.h"
 #include "systems/systems.h"
@@ -57,6 +58,7 @@ uint64_t entity_spawn(uint16_t class_id) {
         librg_entity_track(world_tracker(), e);
         librg_entity_track(world_collision_grid(), e);
 		ecs_set(world_ecs(), e, Velocity, { 0 });
+		ecs_set(world_ecs(), e, SleepTimer, { 0 });
         entity_set_position(e, (float)(rand() % world_dim()), (float)(rand() % world_dim()));
 
         librg_entity_owner_set(world_tracker(), e, (int64_t)e);
@@ -98,12 +100,14 @@ bool entity_spawn_provided(uint16_t id) {
 void entity_batch_despawn(uint64_t *ids, size_t num_ids) {
     for (size_t i = 0; i < num_ids; i++ ) {
         librg_entity_untrack(world_collision_grid(), ids[i]);
+        streamer_entity_untrack(ids[i]);
         librg_entity_untrack(world_tracker(), ids[i]);
         ecs_delete(world_ecs(), ids[i]);
     }
 }
 
 void entity_despawn(uint64_t ent_id) {
+    streamer_entity_untrack(ent_id);
     librg_entity_untrack(world_tracker(), ent_id);
     librg_entity_untrack(world_collision_grid(), ent_id);
     ecs_delete(world_ecs(), ent_id);
@@ -114,7 +118,7 @@ void entity_set_position(uint64_t ent_id, float x, float y) {
     Position *p = ecs_get_mut(world_ecs(), ent_id, Position);
     p->x = x;
     p->y = y;
-    librg_entity_chunk_set(world_tracker(), ent_id, librg_chunk_from_realpos(world_tracker(), x, y, 0));
+    streamer_entity_chunk_set(ent_id, librg_chunk_from_realpos(world_tracker(), x, y, 0));
     librg_entity_chunk_set(world_collision_grid(), ent_id, librg_chunk_from_realpos(world_collision_grid(), x, y, 0));
     entity_wake(ent_id);
 }
@@ -123,6 +127,11 @@ void entity_wake(uint64_t ent_id) {
     StreamInfo *si = ecs_get_mut(world_ecs(), ent_id, StreamInfo);
     si->tick_delay = 0.0f;
     si->last_update = 0.0f;
+
+    if (ecs_has(world_ecs(), ent_id, Sleeping)) {
+        ecs_remove(world_ecs(), ent_id, Sleeping);
+        ecs_get_mut(world_ecs(), ent_id, SleepTimer)->still_ticks = 0;
+    }
 }
 
 static ecs_query_t *ecs_streaminfo = NULL;
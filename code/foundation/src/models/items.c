@@ -2,6 +2,7 @@
 #include "models/entity.h"
 #include "world/entity_view.h"
 #include "world/world.h"
+#include "world/streamer.h"
 #include "world/blocks.h"
 #include "models/database.h"
 
@@ -83,6 +84,7 @@ static inline asset_id item_fix_kind(asset_id id) {
 void item_show(uint64_t ent, bool show) {
     Classify *c = ecs_get_mut(world_ecs(), ent, Classify);
     librg_entity_visibility_global_set(world_tracker(), ent, show ? LIBRG_VISIBLITY_DEFAULT : LIBRG_VISIBLITY_NEVER);
+    streamer_entity_touch(ent);
     c->id = show ? EKIND_ITEM : EKIND_SERVER;
 }
 
@@ -1,9 +1,24 @@
 #pragma once
 #include "platform/system.h"
+#include "pkt/packet.h"
+
+#define NETWORK_MAX_PEERS 8
+
+// NOTE(zaklaus): channels are drained in priority order, see network_enet.c for their send policy
+typedef enum {
+    NETWORK_CHANNEL_WORLD,    // welcome, chunk streams, entity creates/updates/removes
+    NETWORK_CHANNEL_EVENTS,   // notifications, codes
+    NETWORK_CHANNEL_INPUT,    // client input
+
+    NETWORK_CHANNEL_COUNT
+} network_channel_kind;
 
 int32_t network_init(void);
 int32_t network_destroy(void);
 
+// NOTE(zaklaus): peer and channel limits, call before starting the server or connecting
+void network_setup(uint32_t peer_limit, uint32_t channel_limit);
+
 // NOTE(zaklaus): client
 int32_t network_client_connect(const char *host, uint16_t port);
 int32_t network_client_disconnect(void);
@@ -40,8 +55,79 @@ int32_t network_server_start(const char *host, uint16_t port);
 int32_t network_server_stop(void);
 int32_t network_server_tick(void);
 void   network_server_despawn_viewers(void *peer_id);
+void   network_server_assign_entity(void *peer_id, uint16_t view_id, uint64_t ent_id);
 uint64_t network_server_get_entity(void *peer_id, uint16_t view_id);
 
+// NOTE(zaklaus): server stats, sampled on the io thread only while enabled
+typedef enum {
+    NETWORK_STATS_CSV,
+    NETWORK_STATS_JSON,
+} network_stats_format;
+
+typedef struct {
+    uint16_t peer_id;
+
+    // NOTE(zaklaus): ping
+    uint32_t rtt;
+    uint32_t rtt_variance;
+
+    // NOTE(zaklaus): packet integrity
+    uint64_t packets_sent;
+    uint32_t resends; // reliable packets that timed out and went out again
+    float packet_loss;
+
+    // NOTE(zaklaus): bandwidth
+    uint64_t total_sent;
+    uint64_t total_received;
+    float outgoing_bandwidth; // bytes/sec
+    float incoming_bandwidth; // bytes/sec
+
+    // NOTE(zaklaus): queue depth
+    uint32_t reliable_in_flight; // sent, waiting for an ack
+    uint32_t reliable_queued;    // waiting in enet for the send window
+    uint32_t outbox_queued;      // held back by our channel quotas
+
+    // NOTE(zaklaus): outgoing messages before coalescing, headers included
+    uint64_t msg_bytes[MSG_NEXT_FREE_ID];
+    uint32_t msg_count[MSG_NEXT_FREE_ID];
+} network_peer_stats;
+
+// NOTE(zaklaus): path of NULL or "-" dumps to stdout, call before starting the server
+void     network_server_stats_setup(const char *path, network_stats_format format);
+bool     network_server_stats_enabled(void);
+
+// NOTE(zaklaus): fills stats for connected peers, returns the amount written
+uint32_t network_server_fetch_stats(network_peer_stats *stats, uint32_t max_stats);
+
+// NOTE(zaklaus): packet pool, enet allocations are served from size-classed free lists
+#define NETWORK_POOL_CLASSES 7
+
+typedef struct {
+    uint32_t class_size[NETWORK_POOL_CLASSES];
+    uint64_t hits[NETWORK_POOL_CLASSES];
+    uint64_t misses[NETWORK_POOL_CLASSES];
+    uint64_t drops[NETWORK_POOL_CLASSES]; // freed back to the heap, the class was full
+    uint32_t cached[NETWORK_POOL_CLASSES];
+
+    uint64_t total_hits;
+    uint64_t total_misses;
+    uint64_t oversized; // bigger than the largest class, never pooled
+} network_pool_stats;
+
+network_pool_stats network_fetch_pool_stats(void);
+void network_print_pool_stats(void);
+
 // NOTE(zaklaus): messaging
 int32_t network_msg_send(void *peer_id, void *data, size_t datalen, uint16_t channel_id);
 int32_t network_msg_send_unreliable(void *peer_id, void *data, size_t datalen, uint16_t channel_id);
+
+// NOTE(zaklaus): in-place messaging, payload is written straight into the packet buffer
+void   *network_msg_alloc(size_t datalen, int8_t is_reliable, uint8_t **data);
+void    network_msg_free(void *packet);
+int32_t network_msg_send_packet(void *peer_id, void *packet, size_t datalen, uint16_t channel_id);
+
+// NOTE(zaklaus): bots, load generator for a server running in another process, see GAMEKIND_BOTS
+// every bot is a connection of its own, the regular client only ever holds a single one
+int32_t network_bots_start(uint32_t count, bool scripted, const char *host, uint16_t port);
+void    network_bots_stop(void);
+void    network_bots_tick(void);
@@ -0,0 +1,338 @@
+#include "zpl.h"
+
+#pragma warning(push, 0)
+#include "enet.h"
+#pragma warning(pop)
+
+#include "net/network.h"
+#include "pkt/packet.h"
+#include "packets/pkt_00_init.h"
+#include "packets/pkt_01_welcome.h"
+#include "packets/pkt_send_keystate.h"
+#include "packets/pkt_send_librg_update.h"
+#include "world/world.h"
+#include "world/streamer.h"
+#include "world/entity_view.h"
+#include "models/components.h"
+
+// NOTE(zaklaus): bots send their input at a rate similar to a human client
+#define NETWORK_BOTS_INPUT_RATE 0.05
+#define NETWORK_BOTS_REPORT_RATE 5.0
+
+// NOTE(zaklaus): one in this many input frames places or removes a few blocks next to the bot
+#define NETWORK_BOTS_BUILD_CHANCE 40
+
+// NOTE(zaklaus): send times of the most recent input frames, must be a power of two
+#define NETWORK_BOTS_SEQ_WINDOW 128
+
+typedef struct {
+    ENetHost *host;
+    ENetPeer *peer;
+    bool connected;
+    bool joined;
+
+    // NOTE(zaklaus): our own entity as the server addresses it, position comes from its updates
+    uint64_t ent_id;
+    bool has_position;
+    float x, y;
+
+    // NOTE(zaklaus): movement
+    double next_input;
+    double next_turn;
+    float dir_x, dir_y;
+    float phase;
+    pkt_input_history input;
+    double input_sent[NETWORK_BOTS_SEQ_WINDOW];
+
+    // NOTE(zaklaus): stats
+    double init_time;
+    double join_latency;
+    uint64_t bytes_received;
+    uint64_t updates;
+    uint64_t builds;
+    uint32_t acked_seq;
+    uint64_t latency_count;
+    double latency_sum;
+    double latency_max;
+
+    uint64_t report_bytes;
+    uint64_t report_updates;
+} network_bot;
+
+static struct {
+    network_bot *bots;
+    uint32_t count;
+    bool scripted;
+    zpl_random rnd;
+    double start_time;
+    double next_report;
+    double last_report;
+} bots = {0};
+
+static void network_bot_send(network_bot *bot, pkt_messages id, size_t size, bool is_reliable, uint8_t channel_id) {
+    pkt_ctx *ctx = pkt_ctx_local();
+    ENetPacket *packet = enet_packet_create(NULL, PKT_HEADER_RESERVE + size, is_reliable ? ENET_PACKET_FLAG_RELIABLE : 0);
+    if (!packet) return;
+
+    pkt_header_encode_inplace(packet->data, id, 0, size);
+    zpl_memcopy(packet->data + PKT_HEADER_RESERVE, ctx->buffer, size);
+
+    if (enet_peer_send(bot->peer, channel_id, packet) < 0 && packet->referenceCount == 0) {
+        enet_packet_destroy(packet);
+    }
+}
+
+static STREAMER_READ_PROC(network_bot_read_entity) {
+    network_bot *bot = (network_bot*)userdata;
+    if ((uint64_t)entity_id != bot->ent_id) return 0;
+
+    entity_view view = entity_view_unpack_struct(pkt_ctx_local(), buffer, length);
+    bot->x = view.x;
+    bot->y = view.y;
+    bot->has_position = true;
+    return 0;
+}
+
+// NOTE(zaklaus): the update echoes the newest input frame the server applied before producing it
+static void network_bot_ack_input(network_bot *bot, uint32_t input_seq, double now) {
+    if (!input_seq || (int32_t)(input_seq - bot->acked_seq) <= 0) return;
+    bot->acked_seq = input_seq;
+
+    // NOTE(zaklaus): too old to still have its send time around
+    if (bot->input.seq - input_seq >= NETWORK_BOTS_SEQ_WINDOW) return;
+
+    double latency = now - bot->input_sent[input_seq & (NETWORK_BOTS_SEQ_WINDOW - 1)];
+    bot->latency_sum += latency;
+    bot->latency_max = zpl_max(bot->latency_max, latency);
+    bot->latency_count += 1;
+}
+
+static void network_bot_read_msg(network_bot *bot, uint8_t *data, size_t datalen) {
+    pkt_header header = {0};
+    if (pkt_header_decode(&header, data, datalen) < 0 || !header.ok) return;
+    header.ctx = pkt_ctx_local();
+
+    double now = zpl_time_rel();
+
+    switch (header.id) {
+        case MSG_ID_01_WELCOME: {
+            pkt_01_welcome table;
+            if (pkt_01_welcome_decode(&header, &table) < 0) return;
+            bot->ent_id = table.ent_id;
+            bot->joined = true;
+            bot->join_latency = now - bot->init_time;
+        } break;
+        case MSG_ID_LIBRG_UPDATE: {
+            uint8_t layer_id = 0;
+            uint32_t input_seq = 0;
+            void *stream = NULL;
+            size_t stream_len = 0;
+            if (pkt_send_librg_update_decode(&header, &layer_id, &input_seq, &stream, &stream_len) < 0) return;
+
+            streamer_read(stream, stream_len, bot, network_bot_read_entity, network_bot_read_entity, NULL);
+            network_bot_ack_input(bot, input_seq, now);
+            bot->updates += 1;
+        } break;
+    }
+}
+
+static void network_bot_read(network_bot *bot, uint8_t *data, size_t datalen) {
+    bot->bytes_received += datalen;
+
+    if (datalen == 0 || data[0] != PKT_BATCH_MARKER) {
+        network_bot_read_msg(bot, data, datalen);
+        return;
+    }
+
+    size_t offset = 1;
+    while (offset + PKT_BATCH_FRAME_SIZE <= datalen) {
+        size_t len = data[offset] | (data[offset + 1] << 8);
+        offset += PKT_BATCH_FRAME_SIZE;
+        if (len > datalen - offset) break;
+        network_bot_read_msg(bot, data + offset, len);
+        offset += len;
+    }
+}
+
+// NOTE(zaklaus): zpl_random's low bits get stuck for some seeds, so integer rolls are derived from the float range
+static inline int64_t network_bots_range(int64_t lower_inc, int64_t higher_inc) {
+    int64_t value = lower_inc + (int64_t)(zpl_random_range_f64(&bots.rnd, 0.0, 1.0) * (double)(higher_inc - lower_inc + 1));
+    return zpl_min(value, higher_inc);
+}
+
+// NOTE(zaklaus): a short row of blocks next to the bot, same positions the build mode would snap to
+static void network_bot_build(network_bot *bot, pkt_send_keystate *keys) {
+    float bx = zpl_floor(bot->x / WORLD_BLOCK_SIZE) * WORLD_BLOCK_SIZE + WORLD_BLOCK_SIZE / 2.0f;
+    float by = zpl_floor(bot->y / WORLD_BLOCK_SIZE) * WORLD_BLOCK_SIZE + WORLD_BLOCK_SIZE / 2.0f;
+    float side = network_bots_range(0, 1) ? 2.0f : -2.0f;
+
+    keys->selected_item = (uint8_t)network_bots_range(0, ITEMS_CONTAINER_SIZE - 1);
+    keys->deletion_mode = network_bots_range(0, 3) == 0;
+    keys->placement_num = (uint8_t)network_bots_range(1, 3);
+
+    for (uint8_t i = 0; i < keys->placement_num; i += 1) {
+        keys->placements[i] = (item_placement){
+            .x = bx + side * WORLD_BLOCK_SIZE,
+            .y = by + (i - 1) * WORLD_BLOCK_SIZE,
+        };
+    }
+
+    bot->builds += 1;
+}
+
+static void network_bot_input(network_bot *bot, double now) {
+    if (bots.scripted) {
+        // NOTE(zaklaus): walk in circles, every bot on its own phase
+        bot->phase += (float)NETWORK_BOTS_INPUT_RATE;
+        bot->dir_x = zpl_cos(bot->phase);
+        bot->dir_y = zpl_sin(bot->phase);
+    } else if (bot->next_turn < now) {
+        bot->dir_x = (float)network_bots_range(-1, 1);
+        bot->dir_y = (float)network_bots_range(-1, 1);
+        bot->next_turn = now + zpl_random_range_f64(&bots.rnd, 0.5, 3.0);
+    }
+
+    pkt_input_frame frame = {
+        .keys = {
+            .x = bot->dir_x,
+            .y = bot->dir_y,
+            .mx = bot->x,
+            .my = bot->y,
+            .sprint = network_bots_range(0, 9) == 0,
+            .use = network_bots_range(0, 19) == 0,
+            .pick = network_bots_range(0, 19) == 0,
+            .drop = network_bots_range(0, 99) == 0,
+        },
+        .bx = bot->x,
+        .by = bot->y,
+    };
+
+    if (bot->has_position && network_bots_range(0, NETWORK_BOTS_BUILD_CHANCE - 1) == 0) {
+        network_bot_build(bot, &frame.keys);
+    }
+
+    pkt_input_history_push(&bot->input, &frame);
+    bot->input_sent[bot->input.seq & (NETWORK_BOTS_SEQ_WINDOW - 1)] = now;
+    network_bot_send(bot, MSG_ID_SEND_KEYSTATE, pkt_input_history_encode(pkt_ctx_local(), &bot->input), false, NETWORK_CHANNEL_INPUT);
+}
+
+static void network_bots_report(double now) {
+    double window = zpl_max(now - bots.last_report, 0.001);
+    uint32_t joined = 0;
+    uint64_t latency_count = 0;
+    double latency_sum = 0.0, latency_max = 0.0;
+
+    for (uint32_t i = 0; i < bots.count; i += 1) {
+        network_bot *bot = &bots.bots[i];
+        joined += bot->joined;
+        latency_count += bot->latency_count;
+        latency_sum += bot->latency_sum;
+        latency_max = zpl_max(latency_max, bot->latency_max);
+    }
+
+    zpl_printf("[INFO] bots: %d/%d joined after %.1f s, input latency avg %.1f ms max %.1f ms over %llu inputs\n",
+               joined, bots.count, now - bots.start_time,
+               latency_count ? latency_sum / latency_count * 1000.0 : 0.0, latency_max * 1000.0, (unsigned long long)latency_count);
+
+    network_print_pool_stats();
+
+    for (uint32_t i = 0; i < bots.count; i += 1) {
+        network_bot *bot = &bots.bots[i];
+        double kbps = (bot->bytes_received - bot->report_bytes) / 1024.0 / window;
+        double ups = (bot->updates - bot->report_updates) / window;
+        double latency_avg = bot->latency_count ? bot->latency_sum / bot->latency_count : 0.0;
+
+        zpl_printf("[INFO] bot %3d: %8.2f KiB/s, %6.1f updates/s, input latency avg %6.1f ms max %6.1f ms, rtt %4d ms, join %6.1f ms, %llu builds\n",
+                   i, kbps, ups, latency_avg * 1000.0, bot->latency_max * 1000.0,
+                   bot->peer ? bot->peer->roundTripTime : 0, bot->join_latency * 1000.0, (unsigned long long)bot->builds);
+
+        bot->report_bytes = bot->bytes_received;
+        bot->report_updates = bot->updates;
+    }
+
+    bots.last_report = now;
+}
+
+int32_t network_bots_start(uint32_t count, bool scripted, const char *hostname, uint16_t port) {
+    ENetAddress address = {0}; address.port = port;
+    enet_address_set_host(&address, hostname);
+
+    bots.bots = zpl_malloc(sizeof(network_bot) * count);
+    zpl_memset(bots.bots, 0, sizeof(network_bot) * count);
+    bots.count = count;
+    bots.scripted = scripted;
+    zpl_random_init(&bots.rnd);
+    bots.start_time = bots.last_report = zpl_time_rel();
+    bots.next_report = bots.start_time + NETWORK_BOTS_REPORT_RATE;
+
+    for (uint32_t i = 0; i < count; i += 1) {
+        network_bot *bot = &bots.bots[i];
+        bot->host = enet_host_create(NULL, 1, NETWORK_CHANNEL_COUNT, 0, 0);
+        bot->peer = bot->host ? enet_host_connect(bot->host, &address, NETWORK_CHANNEL_COUNT, 0) : NULL;
+        bot->phase = (float)i;
+
+        if (!bot->peer) {
+            zpl_printf("[ERROR] Bot %d cannot connect to %s:%d\n", i, hostname, port);
+            return 1;
+        }
+    }
+
+    zpl_printf("[INFO] Spawned %d %s bots against %s:%d\n", count, scripted ? "scripted" : "random", hostname, port);
+    return 0;
+}
+
+void network_bots_stop(void) {
+    if (!bots.bots) return;
+    network_bots_report(zpl_time_rel());
+
+    for (uint32_t i = 0; i < bots.count; i += 1) {
+        network_bot *bot = &bots.bots[i];
+        if (bot->peer) enet_peer_disconnect_now(bot->peer, 0);
+        if (bot->host) enet_host_destroy(bot->host);
+    }
+
+    zpl_mfree(bots.bots);
+    zpl_memset(&bots, 0, sizeof(bots));
+}
+
+void network_bots_tick(void) {
+    if (!bots.bots) return;
+
+    double now = zpl_time_rel();
+
+    for (uint32_t i = 0; i < bots.count; i += 1) {
+        network_bot *bot = &bots.bots[i];
+        ENetEvent event = {0};
+
+        while (enet_host_service(bot->host, &event, 0) > 0) {
+            switch (event.type) {
+                case ENET_EVENT_TYPE_CONNECT: {
+                    bot->connected = true;
+                    bot->init_time = zpl_time_rel();
+                    pkt_00_init table = {.view_id = 0};
+                    network_bot_send(bot, MSG_ID_00_INIT, pkt_00_init_encode(pkt_ctx_local(), &table), true, NETWORK_CHANNEL_INPUT);
+                } break;
+                case ENET_EVENT_TYPE_DISCONNECT:
+                case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT: {
+                    zpl_printf("[INFO] Bot %d got disconnected.\n", i);
+                    bot->connected = bot->joined = false;
+                } break;
+                case ENET_EVENT_TYPE_RECEIVE: {
+                    network_bot_read(bot, event.packet->data, event.packet->dataLength);
+                    enet_packet_destroy(event.packet);
+                } break;
+                case ENET_EVENT_TYPE_NONE: break;
+            }
+        }
+
+        if (bot->joined && bot->next_input < now) {
+            bot->next_input = now + NETWORK_BOTS_INPUT_RATE;
+            network_bot_input(bot, now);
+        }
+    }
+
+    if (bots.next_report < now) {
+        bots.next_report = now + NETWORK_BOTS_REPORT_RATE;
+        network_bots_report(now);
+    }
+}
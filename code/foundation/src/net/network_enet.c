@@ -1,4 +1,5 @@
 #include "zpl.h"
+#include <stdatomic.h>
 
 #define ENET_IMPLEMENTATION
 #define _WINSOCK_DEPRECATED_NO_WARNINGS
@@ -22,17 +23,749 @@
 
 #define NETWORK_UPDATE_DELAY 0.100
 
+// NOTE(zaklaus): payload budget of a coalesced datagram, keeps it within a single MTU
+#define NETWORK_OUTBOX_SIZE 1200
+
+// NOTE(zaklaus): enet gets serviced on its own thread, unless the platform lacks threads
+#ifndef NETWORK_IO_THREAD
+#if defined(ZPL_SYSTEM_EMSCRIPTEN)
+#define NETWORK_IO_THREAD 0
+#else
+#define NETWORK_IO_THREAD 1
+#endif
+#endif
+
+#define NETWORK_CHANNEL_PRIORITIES 3
+
+// NOTE(zaklaus): io thread blocks on the socket for at most this long before picking up outgoing packets
+#define NETWORK_IO_WAIT_MS 1
+
+// NOTE(zaklaus): capacity of the queues between the game and io thread, must be a power of two
+#define NETWORK_RING_SIZE 4096
+
 static ENetHost *host = NULL;
 static ENetHost *server = NULL;
 static ENetPeer *peer = NULL;
 static librg_world *world = NULL;
+static bool client_connected = false;
+
+static uint16_t max_peers = NETWORK_MAX_PEERS;
+static uint8_t channel_count = NETWORK_CHANNEL_COUNT;
+
+//~ NOTE(zaklaus): viewer lookup
+
+// NOTE(zaklaus): (peer, view_id) -> entity, peers map to the amount of view ids they used
+ZPL_TABLE(static, network_viewers, network_viewers_, uint64_t);
+ZPL_TABLE(static, network_peer_views, network_peer_views_, uint16_t);
+
+static network_viewers viewers = {0};
+static network_peer_views peer_views = {0};
+
+static inline uint64_t network_viewer_key(void *peer_id, uint16_t view_id) {
+    return ((uint64_t)(uintptr_t)peer_id << 16) | view_id;
+}
+
+static void network_viewers_ensure(void) {
+    if (viewers.entries) return;
+    network_viewers_init(&viewers, zpl_heap());
+    network_peer_views_init(&peer_views, zpl_heap());
+}
+
+static void network_viewers_free(void) {
+    if (!viewers.entries) return;
+    network_viewers_destroy(&viewers);
+    network_peer_views_destroy(&peer_views);
+    zpl_zero_item(&viewers);
+    zpl_zero_item(&peer_views);
+}
+
+//~ NOTE(zaklaus): io thread
+
+typedef enum {
+    NETWORK_EVENT_CONNECT,
+    NETWORK_EVENT_DISCONNECT,
+    NETWORK_EVENT_RECEIVE,
+    NETWORK_EVENT_SEND,
+} network_event_kind;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t channel_id;
+    enet_uint32 connect_id;
+    ENetPeer *peer;
+    ENetPacket *packet;
+} network_event;
+
+// NOTE(zaklaus): single producer, single consumer
+// the release store of an index publishes the slot access before it, the other side pairs it with an acquire load
+typedef struct {
+    _Atomic uint32_t head;
+    char pad_[64];
+    _Atomic uint32_t tail;
+    network_event items[NETWORK_RING_SIZE];
+} network_ring;
+
+static bool network_ring_push(network_ring *r, network_event const *ev) {
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (tail - atomic_load_explicit(&r->head, memory_order_acquire) == NETWORK_RING_SIZE) return false;
+    r->items[tail & (NETWORK_RING_SIZE - 1)] = *ev;
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+static bool network_ring_pop(network_ring *r, network_event *ev) {
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (head == atomic_load_explicit(&r->tail, memory_order_acquire)) return false;
+    *ev = r->items[head & (NETWORK_RING_SIZE - 1)];
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    return true;
+}
+
+static inline bool network_ring_empty(network_ring *r) {
+    return atomic_load_explicit(&r->head, memory_order_relaxed) == atomic_load_explicit(&r->tail, memory_order_relaxed);
+}
+
+typedef struct {
+    ENetHost *host;
+    bool sample_stats;
+    bool sample_peer;
+    zpl_thread thread;
+    zpl_atomic32 running;
+    network_ring incoming; // NOTE(zaklaus): io -> game
+    network_ring outgoing; // NOTE(zaklaus): game -> io
+
+    // NOTE(zaklaus): client only, raw counters of the server connection copied by the io thread, guarded by peer_lock
+    zpl_mutex peer_lock;
+    network_client_stats peer_stats;
+} network_io;
+
+static network_io *client_io = NULL;
+static network_io *server_io = NULL;
+
+static network_io *network_io_get(ENetPeer *peer_id) {
+    if (client_io && client_io->host == peer_id->host) return client_io;
+    if (server_io && server_io->host == peer_id->host) return server_io;
+    return NULL;
+}
+
+// NOTE(zaklaus): returns false if the event had to be dropped, packet ownership stays with the caller then
+static bool network_io_push_wait(network_io *io, network_ring *r, network_event const *ev) {
+    while (!network_ring_push(r, ev)) {
+#if NETWORK_IO_THREAD
+        // NOTE(zaklaus): the other side is lagging behind, give it a moment to catch up
+        if (!zpl_atomic32_load(&io->running)) return false;
+        zpl_yield_thread();
+#else
+        (void)io;
+        return false;
+#endif
+    }
+    return true;
+}
+
+//~ NOTE(zaklaus): server stats
+
+#define NETWORK_STATS_SAMPLE_RATE 0.25
+#define NETWORK_STATS_DUMP_RATE 1.0
+
+typedef struct {
+    enet_uint32 connect_id;
+    bool connected;
+    double last_sample;
+    network_peer_stats stats;
+} network_peer_sample;
+
+typedef struct {
+    enet_uint32 connect_id;
+    uint64_t msg_bytes[MSG_NEXT_FREE_ID];
+    uint32_t msg_count[MSG_NEXT_FREE_ID];
+} network_peer_counters;
+
+static const char *network_msg_names[MSG_NEXT_FREE_ID] = {
+    [MSG_ID_00_INIT] = "init",
+    [MSG_ID_01_WELCOME] = "welcome",
+    [MSG_ID_LIBRG_UPDATE] = "librg_update",
+    [MSG_ID_SEND_KEYSTATE] = "keystate",
+    [MSG_ID_SWITCH_VIEWER] = "switch_viewer",
+    [MSG_ID_SEND_NOTIFICATION] = "notification",
+    [MSG_ID_SEND_CODE] = "code",
+};
+
+static struct {
+    bool enabled;
+    network_stats_format format;
+    zpl_file file;
+    bool has_file;
+    double start_time;
+    double next_dump;
+
+    zpl_mutex lock;
+    double next_sample;              // NOTE(zaklaus): io thread only
+    network_peer_sample *samples;    // NOTE(zaklaus): written by the io thread, guarded by lock
+    network_peer_counters *counters; // NOTE(zaklaus): game thread only
+    network_peer_stats *dump;
+} net_stats = {0};
+
+static void network_stats_sample(ENetHost *host_id) {
+    double now = zpl_time_rel();
+    if (now < net_stats.next_sample) return;
+    net_stats.next_sample = now + NETWORK_STATS_SAMPLE_RATE;
+
+    zpl_mutex_lock(&net_stats.lock);
+    for (size_t i = 0; i < host_id->peerCount; i += 1) {
+        ENetPeer *p = &host_id->peers[i];
+        network_peer_sample *sample = &net_stats.samples[i];
+        network_peer_stats *s = &sample->stats;
+
+        sample->connected = p->state == ENET_PEER_STATE_CONNECTED;
+        if (!sample->connected) continue;
+
+        if (sample->connect_id != p->connectID) {
+            zpl_zero_item(sample);
+            sample->connected = true;
+            sample->connect_id = p->connectID;
+            sample->last_sample = now;
+            s->total_sent = p->totalDataSent;
+            s->total_received = p->totalDataReceived;
+        }
+
+        float elapsed = (float)zpl_max(now - sample->last_sample, NETWORK_STATS_SAMPLE_RATE);
+        s->outgoing_bandwidth = (p->totalDataSent - s->total_sent) / elapsed;
+        s->incoming_bandwidth = (p->totalDataReceived - s->total_received) / elapsed;
+        sample->last_sample = now;
+
+        s->peer_id = p->incomingPeerID;
+        s->rtt = p->roundTripTime;
+        s->rtt_variance = p->roundTripTimeVariance;
+        s->packets_sent = p->totalPacketsSent;
+        s->resends = p->totalPacketsLost;
+        s->packet_loss = p->packetLoss / (float)ENET_PEER_PACKET_LOSS_SCALE;
+        s->total_sent = p->totalDataSent;
+        s->total_received = p->totalDataReceived;
+        s->reliable_in_flight = (uint32_t)enet_list_size(&p->sentReliableCommands);
+        s->reliable_queued = (uint32_t)enet_list_size(&p->outgoingReliableCommands);
+    }
+    zpl_mutex_unlock(&net_stats.lock);
+}
+
+static void network_io_sample_peer(network_io *io) {
+    ENetPeer *p = &io->host->peers[0];
+
+    zpl_mutex_lock(&io->peer_lock);
+    io->peer_stats.incoming_total = p->incomingDataTotal;
+    io->peer_stats.total_received = p->totalDataReceived;
+    io->peer_stats.outgoing_total = p->outgoingDataTotal;
+    io->peer_stats.total_sent = p->totalDataSent;
+    io->peer_stats.packets_sent = p->totalPacketsSent;
+    io->peer_stats.packets_lost = p->totalPacketsLost;
+    io->peer_stats.ping = p->roundTripTime;
+    io->peer_stats.low_ping = p->lowestRoundTripTime;
+    zpl_mutex_unlock(&io->peer_lock);
+}
+
+static void network_io_service(network_io *io, enet_uint32 timeout) {
+    network_event ev;
+
+    while (network_ring_pop(&io->outgoing, &ev)) {
+        // NOTE(zaklaus): peer slot might have been reused by a new connection since the packet was queued
+        bool is_same_peer = ev.peer->state == ENET_PEER_STATE_CONNECTED && ev.peer->connectID == ev.connect_id;
+        if ((!is_same_peer || enet_peer_send(ev.peer, ev.channel_id, ev.packet) < 0) && ev.packet->referenceCount == 0) {
+            enet_packet_destroy(ev.packet);
+        }
+    }
+
+    ENetEvent event = {0};
+    while (enet_host_service(io->host, &event, timeout) > 0) {
+        timeout = 0;
+        ev = (network_event){ .peer = event.peer, .connect_id = event.peer->connectID };
+
+        switch (event.type) {
+            case ENET_EVENT_TYPE_CONNECT: ev.kind = NETWORK_EVENT_CONNECT; break;
+            case ENET_EVENT_TYPE_DISCONNECT:
+            case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT: ev.kind = NETWORK_EVENT_DISCONNECT; break;
+            case ENET_EVENT_TYPE_RECEIVE: {
+                ev.kind = NETWORK_EVENT_RECEIVE;
+                ev.channel_id = event.channelID;
+                ev.packet = event.packet;
+            } break;
+            case ENET_EVENT_TYPE_NONE: continue;
+        }
+
+        if (!network_io_push_wait(io, &io->incoming, &ev) && ev.packet) {
+            enet_packet_destroy(ev.packet);
+        }
+    }
+
+    if (io->sample_stats) {
+        network_stats_sample(io->host);
+    }
+    if (io->sample_peer) {
+        network_io_sample_peer(io);
+    }
+}
+
+static zpl_isize network_io_proc(zpl_thread *thread) {
+    network_io *io = (network_io*)thread->user_data;
+
+    while (zpl_atomic32_load(&io->running)) {
+        network_io_service(io, NETWORK_IO_WAIT_MS);
+    }
+
+    return 0;
+}
+
+static network_io *network_io_start(ENetHost *host_id, bool sample_stats, bool sample_peer) {
+    network_io *io = zpl_malloc(sizeof(network_io));
+    zpl_zero_item(io);
+    io->host = host_id;
+    io->sample_stats = sample_stats;
+    io->sample_peer = sample_peer;
+    zpl_mutex_init(&io->peer_lock);
+    zpl_atomic32_store(&io->running, 1);
+
+#if NETWORK_IO_THREAD
+    zpl_thread_init(&io->thread);
+    zpl_thread_start(&io->thread, network_io_proc, io);
+#endif
+    return io;
+}
+
+static void network_io_stop(network_io *io) {
+    if (!io) return;
+    zpl_atomic32_store(&io->running, 0);
+
+#if NETWORK_IO_THREAD
+    zpl_thread_join(&io->thread);
+    zpl_thread_destroy(&io->thread);
+#endif
+
+    // NOTE(zaklaus): drop whatever did not make it through
+    network_event ev;
+    while (network_ring_pop(&io->outgoing, &ev)) {
+        enet_packet_destroy(ev.packet);
+    }
+    while (network_ring_pop(&io->incoming, &ev)) {
+        if (ev.packet) enet_packet_destroy(ev.packet);
+    }
+
+    zpl_mutex_destroy(&io->peer_lock);
+    zpl_mfree(io);
+}
+
+// NOTE(zaklaus): polls events gathered by the io thread, services enet inline if we have no thread
+static bool network_io_poll(network_io *io, network_event *ev) {
+#if !NETWORK_IO_THREAD
+    if (!network_ring_empty(&io->outgoing) || network_ring_empty(&io->incoming)) {
+        network_io_service(io, 0);
+    }
+#endif
+    return network_ring_pop(&io->incoming, ev);
+}
+
+static bool network_outbox_connect_id(ENetPeer *peer_id, enet_uint32 *connect_id);
+
+static int32_t network_io_send(ENetPeer *peer_id, uint16_t channel_id, ENetPacket *packet) {
+    network_io *io = network_io_get(peer_id);
+    enet_uint32 connect_id = 0;
+    if (!io || !network_outbox_connect_id(peer_id, &connect_id)) {
+        enet_packet_destroy(packet);
+        return -1;
+    }
+
+    network_event ev = {
+        .kind = NETWORK_EVENT_SEND,
+        .channel_id = (uint8_t)channel_id,
+        .connect_id = connect_id,
+        .peer = peer_id,
+        .packet = packet,
+    };
+
+#if !NETWORK_IO_THREAD
+    // NOTE(zaklaus): nobody else is going to drain the queue for us
+    if (!network_ring_push(&io->outgoing, &ev)) {
+        network_io_service(io, 0);
+    }
+    else return 0;
+#endif
+
+    if (!network_io_push_wait(io, &io->outgoing, &ev)) {
+        enet_packet_destroy(packet);
+        return -1;
+    }
+    return 0;
+}
+
+//~ NOTE(zaklaus): outbox
+
+typedef struct {
+    ENetPacket *packet;
+    size_t len;
+} network_outbox;
+
+// NOTE(zaklaus): lower priority goes out first, nothing is throttled here, the world limits its chunk stream itself
+static uint8_t channel_priorities[NETWORK_CHANNEL_COUNT] = {
+    [NETWORK_CHANNEL_WORLD]  = 1,
+    [NETWORK_CHANNEL_EVENTS] = 0,
+    [NETWORK_CHANNEL_INPUT]  = 0,
+};
+
+static inline uint8_t network_channel_priority(uint16_t channel_id) {
+    if (channel_id < NETWORK_CHANNEL_COUNT) return channel_priorities[channel_id];
+
+    // NOTE(zaklaus): extra channels requested via network_setup trail behind everything else
+    return NETWORK_CHANNEL_PRIORITIES - 1;
+}
+
+typedef struct {
+    network_outbox boxes[2]; // NOTE(zaklaus): unreliable, reliable
+    zpl_array(ENetPacket*) queue;
+} network_channel;
+
+// NOTE(zaklaus): stored in ENetPeer::data, messages wait here until the next flush hands them to enet
+// opened by the connect event and freed on disconnect, the game thread never touches the live peer state
+typedef struct {
+    enet_uint32 connect_id; // NOTE(zaklaus): recorded by the io thread when the connection was made
+    uint8_t channel_count;
+    network_channel channels[];
+} network_peer_outbox;
+
+static void network_outbox_close(network_channel *channel, network_outbox *box) {
+    if (!box->packet) return;
+
+    enet_packet_resize(box->packet, box->len);
+    zpl_array_append(channel->queue, box->packet);
+
+    box->packet = NULL;
+    box->len = 0;
+}
+
+static void network_channel_dispatch(ENetPeer *peer_id, uint16_t channel_id, network_channel *channel) {
+    network_outbox_close(channel, &channel->boxes[0]);
+    network_outbox_close(channel, &channel->boxes[1]);
+
+    for (zpl_isize i = 0; i < zpl_array_count(channel->queue); i += 1) {
+        network_io_send(peer_id, channel_id, channel->queue[i]);
+    }
+    zpl_array_clear(channel->queue);
+}
+
+static void network_outbox_flush_peer(ENetPeer *peer_id) {
+    network_peer_outbox *outbox = peer_id->data;
+    if (!outbox) return;
+
+    for (uint8_t priority = 0; priority < NETWORK_CHANNEL_PRIORITIES; priority += 1) {
+        for (uint16_t i = 0; i < outbox->channel_count; i += 1) {
+            if (network_channel_priority(i) != priority) continue;
+            network_channel_dispatch(peer_id, i, &outbox->channels[i]);
+        }
+    }
+}
+
+static void network_outbox_flush_all(ENetHost *host_id) {
+    if (!host_id) return;
+
+    for (ENetPeer *p = host_id->peers; p < &host_id->peers[host_id->peerCount]; ++p) {
+        network_outbox_flush_peer(p);
+    }
+}
+
+static void network_outbox_free(ENetPeer *peer_id) {
+    network_peer_outbox *outbox = peer_id->data;
+    if (!outbox) return;
+
+    for (uint16_t i = 0; i < outbox->channel_count; i += 1) {
+        network_channel *channel = &outbox->channels[i];
+        enet_packet_destroy(channel->boxes[0].packet);
+        enet_packet_destroy(channel->boxes[1].packet);
+
+        for (zpl_isize j = 0; j < zpl_array_count(channel->queue); j += 1) {
+            enet_packet_destroy(channel->queue[j]);
+        }
+        zpl_array_free(channel->queue);
+    }
+
+    zpl_mfree(outbox);
+    peer_id->data = NULL;
+}
+
+static void network_outbox_free_all(ENetHost *host_id) {
+    if (!host_id) return;
+
+    for (ENetPeer *p = host_id->peers; p < &host_id->peers[host_id->peerCount]; ++p) {
+        network_outbox_free(p);
+    }
+}
+
+static void network_outbox_open(ENetPeer *peer_id, enet_uint32 connect_id) {
+    // NOTE(zaklaus): whatever is left belongs to the previous connection of this slot
+    network_outbox_free(peer_id);
+
+    zpl_isize size = sizeof(network_peer_outbox) + sizeof(network_channel) * channel_count;
+    network_peer_outbox *outbox = zpl_malloc(size);
+    zpl_memset(outbox, 0, size);
+    outbox->connect_id = connect_id;
+    outbox->channel_count = channel_count;
+
+    for (uint16_t i = 0; i < channel_count; i += 1) {
+        zpl_array_init(outbox->channels[i].queue, zpl_heap());
+    }
+    peer_id->data = outbox;
+}
+
+// NOTE(zaklaus): false if the connection is gone or was never announced to the game thread
+static bool network_outbox_connect_id(ENetPeer *peer_id, enet_uint32 *connect_id) {
+    network_peer_outbox *outbox = peer_id->data;
+    if (!outbox) return false;
+    *connect_id = outbox->connect_id;
+    return true;
+}
+
+static network_channel *network_channel_get(ENetPeer *peer_id, uint16_t channel_id) {
+    network_peer_outbox *outbox = peer_id->data;
+    if (!outbox || channel_id >= outbox->channel_count) return NULL;
+    return &outbox->channels[channel_id];
+}
+
+// NOTE(zaklaus): queues a packet behind everything already waiting on its channel
+static int32_t network_outbox_enqueue(ENetPeer *peer_id, uint16_t channel_id, ENetPacket *packet) {
+    network_channel *channel = network_channel_get(peer_id, channel_id);
+    if (!channel) return network_io_send(peer_id, channel_id, packet);
+
+    network_outbox_close(channel, &channel->boxes[0]);
+    network_outbox_close(channel, &channel->boxes[1]);
+    zpl_array_append(channel->queue, packet);
+    return 0;
+}
+
+// NOTE(zaklaus): appends a message into the outbox, returns false if it is too big to be coalesced
+static bool network_outbox_push(ENetPeer *peer_id, void *data, size_t datalen, uint32_t flags, uint16_t channel_id) {
+    network_channel *channel = network_channel_get(peer_id, channel_id);
+    if (!channel || 1 + PKT_BATCH_FRAME_SIZE + datalen > NETWORK_OUTBOX_SIZE) return false;
+
+    bool is_reliable = (flags & ENET_PACKET_FLAG_RELIABLE) != 0;
+    network_outbox *box = &channel->boxes[is_reliable];
+
+    // NOTE(zaklaus): enet sequences unreliable packets against the reliable ones sent before them,
+    // so the other box goes out first to keep messages in the order they were written
+    network_outbox_close(channel, &channel->boxes[!is_reliable]);
+
+    if (box->packet && box->len + PKT_BATCH_FRAME_SIZE + datalen > NETWORK_OUTBOX_SIZE) {
+        network_outbox_close(channel, box);
+    }
+
+    if (!box->packet) {
+        box->packet = enet_packet_create(NULL, NETWORK_OUTBOX_SIZE, flags);
+        if (!box->packet) return false;
+        box->packet->data[0] = PKT_BATCH_MARKER;
+        box->len = 1;
+    }
+
+    uint8_t *dst = box->packet->data + box->len;
+    dst[0] = (uint8_t)(datalen);
+    dst[1] = (uint8_t)(datalen >> 8);
+    zpl_memcopy(dst + PKT_BATCH_FRAME_SIZE, data, datalen);
+    box->len += PKT_BATCH_FRAME_SIZE + datalen;
+    return true;
+}
+
+static uint32_t network_outbox_queued(ENetPeer *peer_id) {
+    network_peer_outbox *outbox = peer_id->data;
+    if (!outbox) return 0;
+
+    uint32_t queued = 0;
+    for (uint16_t i = 0; i < outbox->channel_count; i += 1) {
+        network_channel *channel = &outbox->channels[i];
+        queued += (uint32_t)zpl_array_count(channel->queue);
+        queued += (channel->boxes[0].packet != NULL) + (channel->boxes[1].packet != NULL);
+    }
+    return queued;
+}
+
+//~ NOTE(zaklaus): packet pool
+
+// NOTE(zaklaus): enet allocates the packet header and its payload as a single block, so the
+// size classes mirror the payloads we actually see: acks and commands, input, coalesced
+// datagrams and chunk streams. Anything bigger goes straight to the heap.
+#ifndef NETWORK_POOL
+#define NETWORK_POOL 1
+#endif
+
+#define NETWORK_POOL_ALIGN 16
+#define NETWORK_POOL_BUDGET (1024*1024)
+
+static const uint32_t network_pool_class_sizes[NETWORK_POOL_CLASSES] = {
+    64, 128, 256, 512,
+    (sizeof(ENetPacket) + NETWORK_OUTBOX_SIZE + NETWORK_POOL_ALIGN - 1) & ~(NETWORK_POOL_ALIGN - 1),
+    4096, 16384,
+};
+
+typedef struct network_pool_block {
+    union {
+        struct network_pool_block *next;
+        uint32_t class_id;
+        uint8_t pad[NETWORK_POOL_ALIGN];
+    };
+} network_pool_block;
+
+typedef struct {
+    zpl_mutex lock;
+    network_pool_block *free_list;
+    uint32_t cached;
+    uint32_t capacity;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t drops;
+} network_pool_class;
+
+static struct {
+    bool ready;
+    network_pool_class classes[NETWORK_POOL_CLASSES];
+    zpl_atomic64 oversized;
+} net_pool = {0};
+
+static void *ENET_CALLBACK network_pool_malloc(size_t size) {
+    uint32_t class_id = 0;
+    while (class_id < NETWORK_POOL_CLASSES && size > network_pool_class_sizes[class_id]) {
+        class_id += 1;
+    }
+
+    network_pool_block *block = NULL;
+
+    if (class_id == NETWORK_POOL_CLASSES) {
+        zpl_atomic64_fetch_add(&net_pool.oversized, 1);
+        block = malloc(sizeof(network_pool_block) + size);
+    } else {
+        network_pool_class *pc = &net_pool.classes[class_id];
+        zpl_mutex_lock(&pc->lock);
+        block = pc->free_list;
+        if (block) {
+            pc->free_list = block->next;
+            pc->cached -= 1;
+            pc->hits += 1;
+        } else {
+            pc->misses += 1;
+        }
+        zpl_mutex_unlock(&pc->lock);
+
+        if (!block) block = malloc(sizeof(network_pool_block) + network_pool_class_sizes[class_id]);
+    }
+
+    if (!block) return NULL;
+    block->class_id = class_id;
+    return block + 1;
+}
+
+static void ENET_CALLBACK network_pool_free(void *memory) {
+    if (!memory) return;
+    network_pool_block *block = (network_pool_block*)memory - 1;
+    uint32_t class_id = block->class_id;
+
+    if (class_id < NETWORK_POOL_CLASSES) {
+        network_pool_class *pc = &net_pool.classes[class_id];
+        zpl_mutex_lock(&pc->lock);
+        if (pc->cached < pc->capacity) {
+            block->next = pc->free_list;
+            pc->free_list = block;
+            pc->cached += 1;
+            block = NULL;
+        } else {
+            pc->drops += 1;
+        }
+        zpl_mutex_unlock(&pc->lock);
+    }
+
+    free(block);
+}
+
+static void network_pool_init(void) {
+    if (net_pool.ready) return;
+    net_pool.ready = true;
+
+    for (uint32_t i = 0; i < NETWORK_POOL_CLASSES; i += 1) {
+        network_pool_class *pc = &net_pool.classes[i];
+        zpl_mutex_init(&pc->lock);
+        pc->capacity = zpl_max(NETWORK_POOL_BUDGET / network_pool_class_sizes[i], 64);
+    }
+}
+
+// NOTE(zaklaus): releases the cached blocks, the locks stay around since enet may still free packets later on
+static void network_pool_drain(void) {
+    if (!net_pool.ready) return;
+
+    for (uint32_t i = 0; i < NETWORK_POOL_CLASSES; i += 1) {
+        network_pool_class *pc = &net_pool.classes[i];
+        zpl_mutex_lock(&pc->lock);
+        network_pool_block *block = pc->free_list;
+        pc->free_list = NULL;
+        pc->cached = 0;
+        zpl_mutex_unlock(&pc->lock);
+
+        while (block) {
+            network_pool_block *next = block->next;
+            free(block);
+            block = next;
+        }
+    }
+}
+
+network_pool_stats network_fetch_pool_stats(void) {
+    network_pool_stats stats = {0};
+    if (!net_pool.ready) return stats;
+
+    for (uint32_t i = 0; i < NETWORK_POOL_CLASSES; i += 1) {
+        network_pool_class *pc = &net_pool.classes[i];
+        zpl_mutex_lock(&pc->lock);
+        stats.class_size[i] = network_pool_class_sizes[i];
+        stats.hits[i] = pc->hits;
+        stats.misses[i] = pc->misses;
+        stats.drops[i] = pc->drops;
+        stats.cached[i] = pc->cached;
+        zpl_mutex_unlock(&pc->lock);
+
+        stats.total_hits += stats.hits[i];
+        stats.total_misses += stats.misses[i];
+    }
+
+    stats.oversized = (uint64_t)zpl_atomic64_load(&net_pool.oversized);
+    return stats;
+}
+
+void network_print_pool_stats(void) {
+    network_pool_stats stats = network_fetch_pool_stats();
+    uint64_t total = stats.total_hits + stats.total_misses;
+
+    zpl_printf("[INFO] packet pool: %.1f%% hits (%llu/%llu), %llu oversized\n",
+               total ? stats.total_hits * 100.0 / total : 0.0,
+               (unsigned long long)stats.total_hits, (unsigned long long)total, (unsigned long long)stats.oversized);
+
+    for (uint32_t i = 0; i < NETWORK_POOL_CLASSES; i += 1) {
+        zpl_printf("[INFO] packet pool %5d B: %llu hits, %llu misses, %llu drops, %d cached\n", stats.class_size[i],
+                   (unsigned long long)stats.hits[i], (unsigned long long)stats.misses[i],
+                   (unsigned long long)stats.drops[i], stats.cached[i]);
+    }
+}
 
 int32_t network_init() {
+#if NETWORK_POOL
+    network_pool_init();
+    ENetCallbacks callbacks = {0};
+    callbacks.malloc = network_pool_malloc;
+    callbacks.free = network_pool_free;
+    callbacks.no_memory = abort;
+    return enet_initialize_with_callbacks(ENET_VERSION, &callbacks) != 0;
+#else
     return enet_initialize() != 0;
+#endif
+}
+
+void network_setup(uint32_t peer_limit, uint32_t channel_limit) {
+    max_peers = (uint16_t)zpl_clamp(peer_limit, 1, ENET_PROTOCOL_MAXIMUM_PEER_ID);
+    channel_count = (uint8_t)zpl_clamp(channel_limit, NETWORK_CHANNEL_COUNT, ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT);
 }
 
 int32_t network_destroy() {
     enet_deinitialize();
+    network_pool_drain();
     return 0;
 }
 
@@ -42,8 +775,8 @@ int32_t network_client_connect(const char *hostname, uint16_t port) {
     ENetAddress address = {0}; address.port = port;
     enet_address_set_host(&address, hostname);
 
-    host = enet_host_create(NULL, 1, 2, 0, 0);
-    peer = enet_host_connect(host, &address, 2, 0);
+    host = enet_host_create(NULL, 1, channel_count, 0, 0);
+    peer = enet_host_connect(host, &address, channel_count, 0);
 
     if (peer == NULL) {
         zpl_printf("[ERROR] Cannot connect to specicied server: %s:%d\n", hostname, port);
@@ -53,11 +786,17 @@ int32_t network_client_connect(const char *hostname, uint16_t port) {
     world = librg_world_create();
     librg_world_userdata_set(world, peer);
 
+    client_io = network_io_start(host, false, true);
     return 0;
 }
 
 int32_t network_client_disconnect() {
+    network_io_stop(client_io);
+    client_io = NULL;
+    client_connected = false;
+
     enet_peer_disconnect(peer, 0);
+    network_outbox_free_all(host);
     enet_host_destroy(host);
 
     librg_world_destroy(world);
@@ -70,22 +809,27 @@ int32_t network_client_disconnect() {
 }
 
 int32_t network_client_tick() {
-    ENetEvent event = {0};
+    if (!client_io) return 0;
+    network_event event = {0};
+    network_outbox_flush_all(host);
 
-    while (enet_host_service(host, &event, 1) > 0) {
-        switch (event.type) {
-            case ENET_EVENT_TYPE_CONNECT: {
+    while (network_io_poll(client_io, &event)) {
+        switch (event.kind) {
+            case NETWORK_EVENT_CONNECT: {
                 zpl_printf("[INFO] We connected to the server.\n");
+                network_outbox_open(event.peer, event.connect_id);
+                client_connected = true;
                 for (uint32_t i = 0; i < game_world_view_count(); i++) {
-                    pkt_00_init_send(i);
+                    pkt_00_init_send(pkt_ctx_local(), i);
                 }
             } break;
-            case ENET_EVENT_TYPE_DISCONNECT:
-            case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT: {
+            case NETWORK_EVENT_DISCONNECT: {
                 zpl_printf("[INFO] We disconnected from server.\n");
+                network_outbox_free(event.peer);
+                client_connected = false;
             } break;
 
-            case ENET_EVENT_TYPE_RECEIVE: {
+            case NETWORK_EVENT_RECEIVE: {
                 if (!world_read(event.packet->data, (uint32_t)event.packet->dataLength, event.peer)) {
                     zpl_printf("[INFO] Server sent us an unsupported packet.\n");
                 }
@@ -93,8 +837,6 @@ int32_t network_client_tick() {
                 /* Clean up the packet now that we're done using it. */
                 enet_packet_destroy(event.packet);
             } break;
-
-            case ENET_EVENT_TYPE_NONE: break;
         }
     }
 
@@ -102,19 +844,17 @@ int32_t network_client_tick() {
 }
 
 bool network_client_is_connected() {
-    return peer ? enet_peer_get_state(peer) == ENET_PEER_STATE_CONNECTED : false;
+    return peer ? client_connected : false;
 }
 network_client_stats
 network_client_fetch_stats(void) {
     if (!network_client_is_connected())
         return (network_client_stats){0};
 
-    network_client_stats stats = {0};
-
-    stats.incoming_total = peer->incomingDataTotal;
-    stats.total_received = peer->totalDataReceived;
-    stats.outgoing_total = peer->outgoingDataTotal;
-    stats.total_sent = peer->totalDataSent;
+    // NOTE(zaklaus): the io thread owns the peer, we work off its latest snapshot
+    zpl_mutex_lock(&client_io->peer_lock);
+    network_client_stats stats = client_io->peer_stats;
+    zpl_mutex_unlock(&client_io->peer_lock);
 
     static double next_measure = 0.0;
     static float incoming_bandwidth = 0.0f;
@@ -151,19 +891,154 @@ network_client_fetch_stats(void) {
         stats.outgoing_bandwidth = outgoing_bandwidth;
     }
 
-    stats.packets_sent = peer->totalPacketsSent;
-    stats.packets_lost = peer->totalPacketsLost;
-
     if (stats.packets_sent > 0) {
         stats.packet_loss = stats.packets_lost / (float)stats.packets_sent;
     }
 
-    stats.ping = peer->roundTripTime;
-    stats.low_ping = peer->lowestRoundTripTime;
-
     return stats;
 }
 
+//~ NOTE(zaklaus): server stats
+
+void network_server_stats_setup(const char *path, network_stats_format format) {
+    net_stats.enabled = true;
+    net_stats.format = format;
+
+    if (path && zpl_strcmp(path, "-")) {
+        if (zpl_file_create(&net_stats.file, path) != ZPL_FILE_ERROR_NONE) {
+            zpl_printf("[ERROR] Cannot open %s for network stats, falling back to stdout.\n", path);
+        } else {
+            net_stats.has_file = true;
+        }
+    }
+}
+
+bool network_server_stats_enabled(void) {
+    return net_stats.enabled;
+}
+
+static void network_server_stats_free(void) {
+    if (!net_stats.samples) return;
+    zpl_mutex_destroy(&net_stats.lock);
+    zpl_mfree(net_stats.samples);
+    zpl_mfree(net_stats.counters);
+    zpl_mfree(net_stats.dump);
+    net_stats.samples = NULL;
+    net_stats.counters = NULL;
+    net_stats.dump = NULL;
+
+    if (net_stats.has_file) {
+        zpl_file_close(&net_stats.file);
+        net_stats.has_file = false;
+    }
+}
+
+static inline void network_stats_record(ENetPeer *peer_id, uint8_t const *data, size_t datalen) {
+    if (!net_stats.counters || peer_id->host != server || datalen < PKT_HEADER_RESERVE) return;
+
+    // NOTE(zaklaus): message id sits right after the header's array marker, see pkt_header_encode_inplace
+    uint16_t id = (uint16_t)((data[2] << 8) | data[3]);
+    if (id >= MSG_NEXT_FREE_ID) return;
+
+    enet_uint32 connect_id = 0;
+    if (!network_outbox_connect_id(peer_id, &connect_id)) return;
+
+    network_peer_counters *counters = &net_stats.counters[peer_id->incomingPeerID];
+    if (counters->connect_id != connect_id) {
+        zpl_zero_item(counters);
+        counters->connect_id = connect_id;
+    }
+
+    counters->msg_bytes[id] += datalen;
+    counters->msg_count[id] += 1;
+}
+
+uint32_t network_server_fetch_stats(network_peer_stats *stats, uint32_t max_stats) {
+    if (!net_stats.samples || !server) return 0;
+    uint32_t count = 0;
+
+    zpl_mutex_lock(&net_stats.lock);
+    for (size_t i = 0; i < server->peerCount && count < max_stats; i += 1) {
+        network_peer_sample *sample = &net_stats.samples[i];
+        if (!sample->connected) continue;
+
+        network_peer_stats *s = &stats[count++];
+        *s = sample->stats;
+
+        network_peer_counters *counters = &net_stats.counters[i];
+        if (counters->connect_id == sample->connect_id) {
+            zpl_memcopy(s->msg_bytes, counters->msg_bytes, sizeof(s->msg_bytes));
+            zpl_memcopy(s->msg_count, counters->msg_count, sizeof(s->msg_count));
+        }
+
+        s->outbox_queued = network_outbox_queued(&server->peers[i]);
+    }
+    zpl_mutex_unlock(&net_stats.lock);
+
+    return count;
+}
+
+static void network_stats_dump(void) {
+    double now = zpl_time_rel();
+    if (now < net_stats.next_dump) return;
+    net_stats.next_dump = now + NETWORK_STATS_DUMP_RATE;
+
+    static bool header_written = false;
+    zpl_file *f = net_stats.has_file ? &net_stats.file : zpl_file_get_standard(ZPL_FILE_STANDARD_OUTPUT);
+    uint32_t count = network_server_fetch_stats(net_stats.dump, max_peers);
+    network_pool_stats pool = network_fetch_pool_stats();
+    double time = now - net_stats.start_time;
+
+    if (net_stats.format == NETWORK_STATS_CSV) {
+        if (!header_written) {
+            header_written = true;
+            zpl_fprintf(f, "time,peer,rtt,rtt_variance,packet_loss,packets_sent,resends,total_sent,total_received,"
+                        "outgoing_bandwidth,incoming_bandwidth,reliable_in_flight,reliable_queued,outbox_queued,pool_hits,pool_misses");
+            for (uint16_t id = 0; id < MSG_NEXT_FREE_ID; id += 1) {
+                zpl_fprintf(f, ",%s_bytes,%s_count", network_msg_names[id], network_msg_names[id]);
+            }
+            zpl_fprintf(f, "\n");
+        }
+
+        for (uint32_t i = 0; i < count; i += 1) {
+            network_peer_stats *s = &net_stats.dump[i];
+            zpl_fprintf(f, "%.3f,%d,%d,%d,%.4f,%llu,%d,%llu,%llu,%.1f,%.1f,%d,%d,%d,%llu,%llu",
+                        time, s->peer_id, s->rtt, s->rtt_variance, s->packet_loss,
+                        (unsigned long long)s->packets_sent, s->resends,
+                        (unsigned long long)s->total_sent, (unsigned long long)s->total_received,
+                        s->outgoing_bandwidth, s->incoming_bandwidth,
+                        s->reliable_in_flight, s->reliable_queued, s->outbox_queued,
+                        (unsigned long long)pool.total_hits, (unsigned long long)pool.total_misses);
+            for (uint16_t id = 0; id < MSG_NEXT_FREE_ID; id += 1) {
+                zpl_fprintf(f, ",%llu,%d", (unsigned long long)s->msg_bytes[id], s->msg_count[id]);
+            }
+            zpl_fprintf(f, "\n");
+        }
+        return;
+    }
+
+    // NOTE(zaklaus): one json document per line
+    zpl_fprintf(f, "{\"time\":%.3f,\"pool\":{\"hits\":%llu,\"misses\":%llu,\"oversized\":%llu},\"peers\":[", time,
+                (unsigned long long)pool.total_hits, (unsigned long long)pool.total_misses, (unsigned long long)pool.oversized);
+    for (uint32_t i = 0; i < count; i += 1) {
+        network_peer_stats *s = &net_stats.dump[i];
+        zpl_fprintf(f, "%s{\"peer\":%d,\"rtt\":%d,\"rtt_variance\":%d,\"packet_loss\":%.4f,\"packets_sent\":%llu,\"resends\":%d,"
+                    "\"total_sent\":%llu,\"total_received\":%llu,\"outgoing_bandwidth\":%.1f,\"incoming_bandwidth\":%.1f,"
+                    "\"reliable_in_flight\":%d,\"reliable_queued\":%d,\"outbox_queued\":%d,\"messages\":{",
+                    i > 0 ? "," : "", s->peer_id, s->rtt, s->rtt_variance, s->packet_loss,
+                    (unsigned long long)s->packets_sent, s->resends,
+                    (unsigned long long)s->total_sent, (unsigned long long)s->total_received,
+                    s->outgoing_bandwidth, s->incoming_bandwidth,
+                    s->reliable_in_flight, s->reliable_queued, s->outbox_queued);
+        for (uint16_t id = 0; id < MSG_NEXT_FREE_ID; id += 1) {
+            zpl_fprintf(f, "%s\"%s\":{\"bytes\":%llu,\"count\":%d}", id > 0 ? "," : "", network_msg_names[id],
+                        (unsigned long long)s->msg_bytes[id], s->msg_count[id]);
+        }
+        zpl_fprintf(f, "}}");
+    }
+    zpl_fprintf(f, "]}\n");
+}
+
 //~ NOTE(zaklaus): server
 
 int32_t network_server_start(const char *host, uint16_t port) {
@@ -174,36 +1049,59 @@ int32_t network_server_start(const char *host, uint16_t port) {
     address.host = ENET_HOST_ANY;
     address.port = port;
 
-    server = enet_host_create(&address, 8, 2, 0, 0);
+    server = enet_host_create(&address, max_peers, channel_count, 0, 0);
 
     if (server == NULL) {
         zpl_printf("[ERROR] An error occured while trying to create a server host.\n");
         return 1;
     }
 
+    zpl_printf("[INFO] Server is listening on port %d with %d peers and %d channels.\n", port, max_peers, channel_count);
+
+    if (net_stats.enabled) {
+        zpl_mutex_init(&net_stats.lock);
+        net_stats.samples = zpl_malloc(sizeof(network_peer_sample) * max_peers);
+        net_stats.counters = zpl_malloc(sizeof(network_peer_counters) * max_peers);
+        net_stats.dump = zpl_malloc(sizeof(network_peer_stats) * max_peers);
+        zpl_memset(net_stats.samples, 0, sizeof(network_peer_sample) * max_peers);
+        zpl_memset(net_stats.counters, 0, sizeof(network_peer_counters) * max_peers);
+        net_stats.start_time = zpl_time_rel();
+        net_stats.next_dump = net_stats.start_time + NETWORK_STATS_DUMP_RATE;
+    }
+
+    server_io = network_io_start(server, net_stats.enabled, false);
     return 0;
 }
 
 int32_t network_server_stop(void) {
+    network_io_stop(server_io);
+    server_io = NULL;
+    network_server_stats_free();
+    network_viewers_free();
+    network_outbox_free_all(server);
     enet_host_destroy(server);
     server = 0;
     return 0;
 }
 
 int32_t network_server_tick(void) {
-    ENetEvent event = {0};
-    while (enet_host_service(server, &event, 1) > 0) {
-        switch (event.type) {
-            case ENET_EVENT_TYPE_CONNECT: {
+    if (!server_io) return 0;
+    network_event event = {0};
+    network_outbox_flush_all(server);
+
+    while (network_io_poll(server_io, &event)) {
+        switch (event.kind) {
+            case NETWORK_EVENT_CONNECT: {
                 zpl_printf("[INFO] A new user %d connected.\n", event.peer->incomingPeerID);
+                network_outbox_open(event.peer, event.connect_id);
             } break;
-            case ENET_EVENT_TYPE_DISCONNECT:
-            case ENET_EVENT_TYPE_DISCONNECT_TIMEOUT: {
+            case NETWORK_EVENT_DISCONNECT: {
                 zpl_printf("[INFO] A user %d disconnected.\n", event.peer->incomingPeerID);
                 network_server_despawn_viewers(event.peer);
+                network_outbox_free(event.peer);
             } break;
 
-            case ENET_EVENT_TYPE_RECEIVE: {
+            case NETWORK_EVENT_RECEIVE: {
                 if (!world_read(event.packet->data, (uint32_t)event.packet->dataLength, event.peer)) {
                     zpl_printf("[INFO] User %d sent us a malformed packet.\n", event.peer->incomingPeerID);
                 }
@@ -211,51 +1109,70 @@ int32_t network_server_tick(void) {
                 /* Clean up the packet now that we're done using it. */
                 enet_packet_destroy(event.packet);
             } break;
-
-            case ENET_EVENT_TYPE_NONE: break;
         }
     }
 
+    if (net_stats.enabled) {
+        network_stats_dump();
+    }
+
     return 0;
 }
 
-void network_server_despawn_viewers(void *peer_id) {
-    ecs_iter_t it = ecs_query_iter(world_ecs(), world_ecs_clientinfo());
+void network_server_assign_entity(void *peer_id, uint16_t view_id, uint64_t ent_id) {
+    network_viewers_ensure();
+    network_viewers_set(&viewers, network_viewer_key(peer_id, view_id), ent_id);
+
+    uint16_t *views = network_peer_views_get(&peer_views, (uint64_t)(uintptr_t)peer_id);
+    if (!views) {
+        network_peer_views_set(&peer_views, (uint64_t)(uintptr_t)peer_id, view_id + 1);
+    } else if (*views <= view_id) {
+        *views = view_id + 1;
+    }
+}
 
-    while (ecs_query_next(&it)) {
-        ClientInfo *p = ecs_field(&it, ClientInfo, 1);
+void network_server_despawn_viewers(void *peer_id) {
+    network_viewers_ensure();
+    uint16_t *views = network_peer_views_get(&peer_views, (uint64_t)(uintptr_t)peer_id);
+    if (!views) return;
 
-        for (int i = 0; i < it.count; i++) {
-            if (p[i].peer == (uintptr_t)peer_id) {
-                player_despawn(it.entities[i]);
-            }
+    for (uint16_t view_id = 0; view_id < *views; view_id += 1) {
+        uint64_t ent_id = network_server_get_entity(peer_id, view_id);
+        if (ent_id) {
+            player_despawn(ent_id);
         }
+        network_viewers_remove(&viewers, network_viewer_key(peer_id, view_id));
     }
+
+    network_peer_views_remove(&peer_views, (uint64_t)(uintptr_t)peer_id);
 }
 
 uint64_t network_server_get_entity(void *peer_id, uint16_t view_id) {
-    ecs_iter_t it = ecs_query_iter(world_ecs(), world_ecs_clientinfo());
+    network_viewers_ensure();
+    uint64_t key = network_viewer_key(peer_id, view_id);
+    uint64_t *ent_id = network_viewers_get(&viewers, key);
+    if (!ent_id) return 0;
 
-    while (ecs_query_next(&it)) {
-        ClientInfo *p = ecs_field(&it, ClientInfo, 1);
-
-        for (int i = 0; i < it.count; i++) {
-            if (p[i].peer == (uintptr_t)peer_id && p[i].view_id == view_id) {
-                ecs_iter_fini(&it);
-                return it.entities[i];
-            }
-        }
+    // NOTE(zaklaus): entity might have been deleted behind our back
+    const ClientInfo *ci = ecs_is_alive(world_ecs(), *ent_id) ? ecs_get(world_ecs(), *ent_id, ClientInfo) : NULL;
+    if (!ci || ci->peer != (uintptr_t)peer_id || ci->view_id != view_id) {
+        network_viewers_remove(&viewers, key);
+        return 0;
     }
 
-    return 0;
+    return *ent_id;
 }
 
 //~ NOTE(zaklaus): messaging
 
 static int32_t network_msg_send_raw(ENetPeer *peer_id, void *data, size_t datalen, uint32_t flags, uint16_t channel_id) {
     if (peer_id == 0) peer_id = peer;
+    if (peer_id == 0) return -1;
+    network_stats_record(peer_id, data, datalen);
+    if (network_outbox_push(peer_id, data, datalen, flags, channel_id)) return 0;
     ENetPacket *packet = enet_packet_create(data, datalen, flags);
-    return enet_peer_send(peer_id, (enet_uint8)channel_id, packet);
+    if (!packet) return -1;
+    return network_outbox_enqueue(peer_id, channel_id, packet);
 }
 
 int32_t network_msg_send(void *peer_id, void *data, size_t datalen, uint16_t channel_id) {
@@ -265,3 +1182,28 @@ int32_t network_msg_send(void *peer_id, void *data, size_t datalen, uint16_t cha
 int32_t network_msg_send_unreliable(void *peer_id, void *data, size_t datalen, uint16_t channel_id) {
     return network_msg_send_raw(peer_id, data, datalen, 0, channel_id);
 }
+
+void *network_msg_alloc(size_t datalen, int8_t is_reliable, uint8_t **data) {
+    ENetPacket *packet = enet_packet_create(NULL, datalen, is_reliable ? ENET_PACKET_FLAG_RELIABLE : 0);
+    *data = packet ? packet->data : NULL;
+    return packet;
+}
+
+void network_msg_free(void *packet) {
+    enet_packet_destroy((ENetPacket*)packet);
+}
+
+int32_t network_msg_send_packet(void *peer_id, void *packet, size_t datalen, uint16_t channel_id) {
+    ENetPeer *peer_ptr = peer_id ? (ENetPeer*)peer_id : peer;
+    ENetPacket *pkt = (ENetPacket*)packet;
+    network_stats_record(peer_ptr, pkt->data, datalen);
+
+    if (network_outbox_push(peer_ptr, pkt->data, datalen, pkt->flags, channel_id)) {
+        enet_packet_destroy(pkt);
+        return 0;
+    }
+
+    // NOTE(zaklaus): shrinking is done in place, the unused capacity is simply ignored
+    enet_packet_resize(pkt, datalen);
+    return network_outbox_enqueue(peer_ptr, channel_id, pkt);
+}
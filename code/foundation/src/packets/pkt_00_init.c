@@ -12,19 +12,20 @@
 #include "models/components.h"
 #include "systems/systems.h"
 
-pkt_desc pkt_00_init_desc[] = {
-    { PKT_FIELD(CWP_ITEM_POSITIVE_INTEGER, pkt_00_init, view_id) },
-    { PKT_END },
-};
+#define PKT_CODEC_NAME pkt_00_init
+#define PKT_CODEC_TYPE pkt_00_init
+#define PKT_CODEC_FIELDS(F, KEEP_IF, SKIP_IF, END_IF) \
+    F(UINT, view_id)
+#include "pkt/packet_codec.h"
 
-size_t pkt_00_init_send(uint16_t view_id) {
+size_t pkt_00_init_send(pkt_ctx *ctx, uint16_t view_id) {
     pkt_00_init table = {.view_id = view_id };
-    return pkt_world_write(MSG_ID_00_INIT, pkt_table_encode(pkt_00_init_desc, PKT_STRUCT_PTR(&table)), 1, view_id, NULL, 1);
+    return pkt_world_write(ctx, MSG_ID_00_INIT, pkt_00_init_encode(ctx, &table), 1, view_id, NULL, NETWORK_CHANNEL_INPUT);
 }
 
 int32_t pkt_00_init_handler(pkt_header *header) {
     pkt_00_init table;
-    PKT_IF(pkt_msg_decode(header, pkt_00_init_desc, pkt_pack_desc_args(pkt_00_init_desc), PKT_STRUCT_PTR(&table)));
+    PKT_IF(pkt_00_init_decode(header, &table));
 
     uint64_t peer_id = (uint64_t)header->udata;
     uint64_t ent_id = player_spawn(NULL);
@@ -35,6 +36,8 @@ int32_t pkt_00_init_handler(pkt_header *header) {
 
     zpl_printf("[INFO] initializing player entity id: %d with view id: %d for peer id: %d...\n", ent_id, table.view_id, peer_id);
     ecs_set(world_ecs(), ent_id, ClientInfo, {.peer = peer_id, .view_id = header->view_id, .active = false });
-    pkt_01_welcome_send(world_seed(), peer_id, header->view_id, ent_id, world_chunk_size(), world_chunk_amount());
+    network_server_assign_entity(header->udata, header->view_id, ent_id);
+    world_entity_handles_add_owner(ent_id);
+    pkt_01_welcome_send(header->ctx, world_seed(), peer_id, header->view_id, world_entity_wire_id(ent_id, ent_id), world_chunk_size(), world_chunk_amount());
     return 0;
 }
@@ -6,8 +6,8 @@ typedef struct {
     uint16_t view_id;
 } pkt_00_init;
 
-size_t pkt_00_init_send(uint16_t view_id);
-extern pkt_desc pkt_00_init_desc[];
+size_t pkt_00_init_send(pkt_ctx *ctx, uint16_t view_id);
+PKT_CODEC_DECLARE(pkt_00_init, pkt_00_init);
 
 PKT_HANDLER_PROC(pkt_00_init_handler);
 
@@ -1,31 +1,34 @@
 #include "packets/pkt_01_welcome.h"
 #include "pkt/packet.h"
+#include "net/network.h"
 #include "world/world.h"
 #include "core/game.h"
 #include "world/entity_view.h"
 #include "core/camera.h"
 
-pkt_desc pkt_01_welcome_desc[] = {
-    { PKT_FIELD(CWP_ITEM_POSITIVE_INTEGER, pkt_01_welcome, seed) },
-    { PKT_FIELD(CWP_ITEM_POSITIVE_INTEGER, pkt_01_welcome, ent_id) },
-    { PKT_FIELD(CWP_ITEM_POSITIVE_INTEGER, pkt_01_welcome, chunk_size) },
-    { PKT_FIELD(CWP_ITEM_POSITIVE_INTEGER, pkt_01_welcome, world_size) },
-    { PKT_END },
-};
+#define PKT_CODEC_NAME pkt_01_welcome
+#define PKT_CODEC_TYPE pkt_01_welcome
+#define PKT_CODEC_FIELDS(F, KEEP_IF, SKIP_IF, END_IF) \
+    F(UINT, seed) \
+    F(UINT, ent_id) \
+    F(UINT, chunk_size) \
+    F(UINT, world_size)
+#include "pkt/packet_codec.h"
 
-size_t pkt_01_welcome_send(uint32_t seed,
+size_t pkt_01_welcome_send(pkt_ctx *ctx,
+                           uint32_t seed,
                            uint64_t peer_id,
                            uint16_t view_id,
                            uint64_t ent_id,
                            uint16_t chunk_size,
                            uint16_t world_size) {
     pkt_01_welcome table = {.seed = seed, .ent_id = ent_id, .chunk_size = chunk_size, .world_size = world_size};
-    return pkt_world_write(MSG_ID_01_WELCOME, pkt_table_encode(pkt_01_welcome_desc, PKT_STRUCT_PTR(&table)), 1, view_id, (void*)peer_id, 0);
+    return pkt_world_write(ctx, MSG_ID_01_WELCOME, pkt_01_welcome_encode(ctx, &table), 1, view_id, (void*)peer_id, NETWORK_CHANNEL_WORLD);
 }
 
 int32_t pkt_01_welcome_handler(pkt_header *header) {
     pkt_01_welcome table;
-    PKT_IF(pkt_msg_decode(header, pkt_01_welcome_desc, pkt_pack_desc_args(pkt_01_welcome_desc), PKT_STRUCT_PTR(&table)));
+    PKT_IF(pkt_01_welcome_decode(header, &table));
 
     world_view *view = game_world_view_get(header->view_id);
 
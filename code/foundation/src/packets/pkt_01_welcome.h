@@ -9,13 +9,14 @@ typedef struct {
     uint16_t world_size;
 } pkt_01_welcome;
 
-size_t pkt_01_welcome_send(uint32_t seed,
+size_t pkt_01_welcome_send(pkt_ctx *ctx,
+                           uint32_t seed,
                            uint64_t peer_id,
                            uint16_t view_id,
                            uint64_t ent_id,
                            uint16_t chunk_size,
                            uint16_t world_size);
-extern pkt_desc pkt_01_welcome_desc[];
+PKT_CODEC_DECLARE(pkt_01_welcome, pkt_01_welcome);
 
 PKT_HANDLER_PROC(pkt_01_welcome_handler);
 
@@ -1,5 +1,6 @@
 #include "packets/pkt_send_code.h"
 #include "pkt/packet.h"
+#include "net/network.h"
 #include "world/world.h"
 #include "core/game.h"
 #include "world/entity_view.h"
@@ -7,20 +8,21 @@
 #include "models/components.h"
 #include "systems/systems.h"
 
-pkt_desc pkt_send_code_desc[] = {
-	{ PKT_UINT(pkt_send_code, code) },
-	{ PKT_ARRAY(pkt_send_code, params) },
-	{ PKT_ARRAY(pkt_send_code, data) },
-	{ PKT_END },
-};
+#define PKT_CODEC_NAME pkt_send_code
+#define PKT_CODEC_TYPE pkt_send_code
+#define PKT_CODEC_FIELDS(F, KEEP_IF, SKIP_IF, END_IF) \
+	F(UINT, code) \
+	F(ARRAY, params) \
+	F(ARRAY, data)
+#include "pkt/packet_codec.h"
 
-size_t pkt_code_send(uint64_t peer_id, uint16_t view_id, pkt_send_code table) {
-	return pkt_world_write(MSG_ID_SEND_CODE, pkt_table_encode(pkt_send_code_desc, PKT_STRUCT_PTR(&table)), 1, view_id, (void*)peer_id, 0);
+size_t pkt_code_send(pkt_ctx *ctx, uint64_t peer_id, uint16_t view_id, pkt_send_code table) {
+	return pkt_world_write(ctx, MSG_ID_SEND_CODE, pkt_send_code_encode(ctx, &table), 1, view_id, (void*)peer_id, NETWORK_CHANNEL_EVENTS);
 }
 
 int32_t pkt_send_code_handler(pkt_header *header) {
 	pkt_send_code table = { 0 };
-	PKT_IF(pkt_msg_decode(header, pkt_send_code_desc, pkt_pack_desc_args(pkt_send_code_desc), PKT_STRUCT_PTR(&table)));
+	PKT_IF(pkt_send_code_decode(header, &table));
 
 	game_client_receive_code(table);
 
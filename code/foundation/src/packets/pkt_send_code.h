@@ -8,8 +8,8 @@ typedef struct {
 	char data[128];
 } pkt_send_code;
 
-size_t pkt_code_send(uint64_t peer_id, uint16_t view_id, pkt_send_code code_data);
-extern pkt_desc pkt_send_code_desc[];
+size_t pkt_code_send(pkt_ctx *ctx, uint64_t peer_id, uint16_t view_id, pkt_send_code code_data);
+PKT_CODEC_DECLARE(pkt_send_code, pkt_send_code);
 
 PKT_HANDLER_PROC(pkt_send_code_handler);
 
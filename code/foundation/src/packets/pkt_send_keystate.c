@@ -8,105 +8,215 @@
 
 #include "dev/debug_replay.h"
 
-pkt_desc pkt_send_keystate_desc[] = {
-    { PKT_REAL(pkt_send_keystate, x) },
-    { PKT_REAL(pkt_send_keystate, y) },
-    { PKT_REAL(pkt_send_keystate, mx) },
-    { PKT_REAL(pkt_send_keystate, my) },
-    { PKT_UINT(pkt_send_keystate, use) },
-    { PKT_UINT(pkt_send_keystate, sprint) },
-    { PKT_UINT(pkt_send_keystate, ctrl) },
-    { PKT_UINT(pkt_send_keystate, pick) },
-    { PKT_UINT(pkt_send_keystate, storage_action) },
-    { PKT_UINT(pkt_send_keystate, selected_item) },
-    { PKT_UINT(pkt_send_keystate, storage_selected_item) },
-    { PKT_UINT(pkt_send_keystate, drop) },
-    { PKT_UINT(pkt_send_keystate, swap) },
-    { PKT_UINT(pkt_send_keystate, swap_storage) },
-    { PKT_UINT(pkt_send_keystate, swap_from) },
-    { PKT_UINT(pkt_send_keystate, swap_to) },
-    { PKT_UINT(pkt_send_keystate, craft_item) },
-    { PKT_UINT(pkt_send_keystate, placement_num) },
-    { PKT_UINT(pkt_send_keystate, deletion_mode) },
-    { PKT_ARRAY(pkt_send_keystate, placements) },
-    { PKT_END },
-};
-
-pkt_desc pkt_send_blockpos_desc[] = {
-    { PKT_REAL(pkt_send_blockpos, mx) },
-    { PKT_REAL(pkt_send_blockpos, my) },
-    { PKT_END },
-};
-
-size_t pkt_send_keystate_send(uint16_t view_id,
-                              game_keystate_data *data) {
-    return pkt_world_write(MSG_ID_SEND_KEYSTATE, pkt_table_encode(pkt_send_keystate_desc, PKT_STRUCT_PTR(data)), 1, view_id, NULL, 1);
+#define PKT_CODEC_NAME pkt_send_keystate
+#define PKT_CODEC_BITS 1
+#define PKT_CODEC_TYPE pkt_send_keystate
+#define PKT_CODEC_FIELDS(F, KEEP_IF, SKIP_IF, END_IF) \
+    F(REAL, x) \
+    F(REAL, y) \
+    F(REAL, mx) \
+    F(REAL, my) \
+    F(UINT, use) \
+    F(UINT, sprint) \
+    F(UINT, ctrl) \
+    F(UINT, pick) \
+    F(UINT, storage_action) \
+    F(UINT, selected_item) \
+    F(UINT, storage_selected_item) \
+    F(UINT, drop) \
+    F(UINT, swap) \
+    F(UINT, swap_storage) \
+    F(UINT, swap_from) \
+    F(UINT, swap_to) \
+    F(UINT, craft_item) \
+    F(UINT, placement_num) \
+    F(UINT, deletion_mode) \
+    F(ARRAY, placements)
+#include "pkt/packet_codec.h"
+
+// NOTE(zaklaus): client-side input history, one per viewer
+static pkt_input_history *input_histories = NULL;
+
+void pkt_input_history_push(pkt_input_history *history, pkt_input_frame const *frame) {
+    if (history->frame_count == PKT_INPUT_REDUNDANCY) {
+        zpl_memmove(history->frames, history->frames + 1, sizeof(pkt_input_frame) * (PKT_INPUT_REDUNDANCY - 1));
+        history->frame_count -= 1;
+    }
+
+    history->frames[history->frame_count++] = *frame;
+    history->seq += 1;
 }
 
-size_t pkt_send_blockpos_send(uint16_t view_id,
-                              pkt_send_blockpos *data){
-    return pkt_world_write(MSG_ID_SEND_BLOCKPOS, pkt_table_encode(pkt_send_blockpos_desc, PKT_STRUCT_PTR(data)), 1, view_id, NULL, 1);
-    
+// NOTE(zaklaus): same layout the codec uses for HALF fields
+static inline void pkt_input_write_real(pkt_bits *bs, float value) {
+    uint32_t num = 0;
+    zpl_memcopy(&num, &value, sizeof(value));
+    pkt_bits_write(bs, num != 0, 1);
+    if (num) pkt_bits_write(bs, num, 32);
 }
 
-int32_t pkt_send_keystate_handler(pkt_header *header) {
-    pkt_send_keystate table;
-    PKT_IF(pkt_msg_decode(header, pkt_send_keystate_desc, pkt_pack_desc_args(pkt_send_keystate_desc), PKT_STRUCT_PTR(&table)));
-    ecs_entity_t e = network_server_get_entity(header->udata, header->view_id);
-    
-    if (!world_entity_valid(e))
-        return 1;
-    
-    Input *i = ecs_get_mut(world_ecs(), e, Input);
-    if (i && !i->is_blocked) {
-        i->x = zpl_clamp(table.x, -1.0f, 1.0f);
-        i->y = zpl_clamp(table.y, -1.0f, 1.0f);
-        i->mx = table.mx;
-        i->my = table.my;
-		if (i->x != 0.0f || i->y != 0.0f) {
-			i->hx = i->x;
-			i->hy = i->y;
-		}
-        i->use |= table.use;
-        i->sprint = table.sprint;
-        i->ctrl = table.ctrl;
-        i->pick |= table.pick;
-        i->selected_item = zpl_clamp(table.selected_item, 0, ITEMS_CONTAINER_SIZE-1);
-        i->storage_selected_item = zpl_clamp(table.storage_selected_item, 0, ITEMS_CONTAINER_SIZE-1);
-        i->drop |= table.drop;
-        i->swap |= table.swap;
-        i->swap_storage |= table.swap_storage;
-        i->swap_from = zpl_clamp(table.swap_from, 0, ITEMS_CONTAINER_SIZE-1);
-        i->swap_to = zpl_clamp(table.swap_to, 0, ITEMS_CONTAINER_SIZE-1);
-        i->craft_item = table.craft_item;
-        i->storage_action = table.storage_action;
-        i->deletion_mode = table.deletion_mode;
-        if (table.placement_num > 0) {
-            i->num_placements = zpl_clamp(table.placement_num, 0, BUILD_MAX_PLACEMENTS);
-            for (uint8_t j = 0; j < i->num_placements; j++) {
-                i->placements_x[j] = table.placements[j].x;
-                i->placements_y[j] = table.placements[j].y;
-            }
+static inline float pkt_input_read_real(pkt_bits *bs) {
+    uint32_t num = 0;
+    float value = 0.0f;
+    if (pkt_bits_read(bs, 1)) num = (uint32_t)pkt_bits_read(bs, 32);
+    zpl_memcopy(&value, &num, sizeof(value));
+    return value;
+}
+
+// NOTE(zaklaus): [uint32 seq, bin frames], frames are a bitstream of [varint count, frame...]
+size_t pkt_input_history_encode(pkt_ctx *ctx, pkt_input_history const *history) {
+    cw_pack_context pc = {0};
+    pkt_pack_msg(ctx, &pc, 2);
+    cw_pack_unsigned(&pc, history->seq);
+
+    // NOTE(zaklaus): bin32 header gets patched once we know the length
+    uint8_t *bin = pc.current;
+    pkt_bits bs = {0};
+    pkt_bits_init(&bs, bin + 5, (uint32_t)(pc.end - bin - 5));
+    pkt_bits_write_varint(&bs, history->frame_count);
+
+    for (uint8_t i = 0; i < history->frame_count; i += 1) {
+        pkt_input_frame const *frame = &history->frames[i];
+        pkt_send_keystate_pack_bits(ctx, &bs, &frame->keys);
+        pkt_input_write_real(&bs, frame->bx);
+        pkt_input_write_real(&bs, frame->by);
+    }
+
+    pkt_bits_flush(&bs);
+    if (bs.error) return 0;
+
+    bin[0] = 0xc6;
+    bin[1] = (uint8_t)(bs.pos >> 24);
+    bin[2] = (uint8_t)(bs.pos >> 16);
+    bin[3] = (uint8_t)(bs.pos >> 8);
+    bin[4] = (uint8_t)(bs.pos);
+    pc.current = bin + 5 + bs.pos;
+    return pkt_pack_msg_size(&pc);
+}
+
+int32_t pkt_input_history_decode(pkt_header *header, pkt_input_history *history) {
+    cw_unpack_context uc = {0};
+    PKT_IF(pkt_unpack_msg(&uc, header, 2));
+
+    cw_unpack_next(&uc);
+    if (uc.item.type != CWP_ITEM_POSITIVE_INTEGER || uc.item.as.u64 > UINT32_MAX) return -1;
+    history->seq = (uint32_t)uc.item.as.u64;
+
+    cw_unpack_next(&uc);
+    if (uc.item.type != CWP_ITEM_BIN) return -1;
+
+    pkt_bits bs = {0};
+    pkt_bits_init(&bs, (void*)uc.item.as.bin.start, uc.item.as.bin.length);
+    uint64_t frame_count = pkt_bits_read_varint(&bs);
+    if (frame_count == 0 || frame_count > PKT_INPUT_REDUNDANCY) return -1;
+    history->frame_count = (uint8_t)frame_count;
+
+    for (uint8_t i = 0; i < history->frame_count; i += 1) {
+        pkt_input_frame *frame = &history->frames[i];
+        pkt_send_keystate_unpack_bits(header->ctx, &bs, &frame->keys);
+        frame->bx = pkt_input_read_real(&bs);
+        frame->by = pkt_input_read_real(&bs);
+    }
+
+    if (bs.error) return -1;
+    return pkt_validate_eof_msg(&uc);
+}
+
+size_t pkt_send_keystate_send(pkt_ctx *ctx,
+                              uint16_t view_id,
+                              game_keystate_data *data,
+                              float bx,
+                              float by) {
+    if (!input_histories) {
+        zpl_array_init(input_histories, zpl_heap());
+    }
+    while (zpl_array_count(input_histories) <= view_id) {
+        pkt_input_history empty = {0};
+        zpl_array_append(input_histories, empty);
+    }
+
+    pkt_input_history *history = &input_histories[view_id];
+    pkt_input_frame frame = { .keys = *data, .bx = bx, .by = by };
+    pkt_input_history_push(history, &frame);
+
+    return pkt_world_write(ctx, MSG_ID_SEND_KEYSTATE, pkt_input_history_encode(ctx, history), 0, view_id, NULL, NETWORK_CHANNEL_INPUT);
+}
+
+size_t pkt_send_keystate_resend(pkt_ctx *ctx, uint16_t view_id) {
+    if (!input_histories || zpl_array_count(input_histories) <= view_id) return 0;
+
+    // NOTE(zaklaus): same frames under the same seq, the server skips whatever it already applied
+    pkt_input_history *history = &input_histories[view_id];
+    if (history->frame_count == 0) return 0;
+
+    return pkt_world_write(ctx, MSG_ID_SEND_KEYSTATE, pkt_input_history_encode(ctx, history), 0, view_id, NULL, NETWORK_CHANNEL_INPUT);
+}
+
+static void pkt_input_frame_apply(Input *i, pkt_input_frame const *frame) {
+    pkt_send_keystate const *table = &frame->keys;
+
+    i->x = zpl_clamp(table->x, -1.0f, 1.0f);
+    i->y = zpl_clamp(table->y, -1.0f, 1.0f);
+    i->mx = table->mx;
+    i->my = table->my;
+    if (i->x != 0.0f || i->y != 0.0f) {
+        i->hx = i->x;
+        i->hy = i->y;
+    }
+    i->use |= table->use;
+    i->sprint = table->sprint;
+    i->ctrl = table->ctrl;
+    i->pick |= table->pick;
+    i->selected_item = zpl_clamp(table->selected_item, 0, ITEMS_CONTAINER_SIZE-1);
+    i->storage_selected_item = zpl_clamp(table->storage_selected_item, 0, ITEMS_CONTAINER_SIZE-1);
+    i->drop |= table->drop;
+    i->swap |= table->swap;
+    i->swap_storage |= table->swap_storage;
+    i->swap_from = zpl_clamp(table->swap_from, 0, ITEMS_CONTAINER_SIZE-1);
+    i->swap_to = zpl_clamp(table->swap_to, 0, ITEMS_CONTAINER_SIZE-1);
+    i->craft_item = table->craft_item;
+    i->storage_action = table->storage_action;
+    i->deletion_mode = table->deletion_mode;
+    if (table->placement_num > 0) {
+        i->num_placements = zpl_clamp(table->placement_num, 0, BUILD_MAX_PLACEMENTS);
+        for (uint8_t j = 0; j < i->num_placements; j++) {
+            i->placements_x[j] = table->placements[j].x;
+            i->placements_y[j] = table->placements[j].y;
         }
-        debug_replay_record_keystate(table);
-        entity_wake(e);
     }
-    
-    return 0;
+    i->bx = frame->bx;
+    i->by = frame->by;
 }
 
-int32_t pkt_send_blockpos_handler(pkt_header *header) {
-    pkt_send_blockpos table;
-    PKT_IF(pkt_msg_decode(header, pkt_send_blockpos_desc, pkt_pack_desc_args(pkt_send_blockpos_desc), PKT_STRUCT_PTR(&table)));
+int32_t pkt_send_keystate_handler(pkt_header *header) {
+    pkt_input_history table;
+    PKT_IF(pkt_input_history_decode(header, &table));
     ecs_entity_t e = network_server_get_entity(header->udata, header->view_id);
     
     if (!world_entity_valid(e))
         return 1;
     
+    ClientInfo *ci = ecs_get_mut(world_ecs(), e, ClientInfo);
     Input *i = ecs_get_mut(world_ecs(), e, Input);
-    if (i && !i->is_blocked) {
-        i->bx = table.mx;
-        i->by = table.my;
+    if (!ci || !i || i->is_blocked)
+        return 0;
+
+    bool applied = false;
+    for (uint8_t j = 0; j < table.frame_count; j++) {
+        uint32_t seq = table.seq - (table.frame_count - 1 - j);
+
+        // NOTE(zaklaus): already applied, or older than what we have
+        if (ci->input_seq != 0 && (int32_t)(seq - ci->input_seq) <= 0)
+            continue;
+
+        pkt_input_frame_apply(i, &table.frames[j]);
+        debug_replay_record_keystate(table.frames[j].keys);
+        ci->input_seq = seq;
+        applied = true;
+    }
+
+    if (applied) {
+        entity_wake(e);
     }
     
     return 0;
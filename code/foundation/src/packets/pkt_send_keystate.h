@@ -1,6 +1,7 @@
 #pragma once
 #include "platform/system.h"
 #include "pkt/packet_utils.h"
+#include "pkt/packet_bits.h"
 #include "models/item_placement.h"
 
 typedef struct {
@@ -30,22 +31,40 @@ typedef struct {
     item_placement placements[BUILD_MAX_PLACEMENTS];
 } pkt_send_keystate;
 
+// NOTE(zaklaus): one sampled input frame, carries the block under the cursor along with the keys
 typedef struct {
-    float mx;
-    float my;
-} pkt_send_blockpos;
+    pkt_send_keystate keys;
+    float bx;
+    float by;
+} pkt_input_frame;
+
+// NOTE(zaklaus): input goes out unreliably, every packet repeats the last few frames
+// so a lost one is covered by the next, the server drops frames it has already seen
+#define PKT_INPUT_REDUNDANCY 4
+
+// NOTE(zaklaus): unchanged input repeats the last history this often, gives lost frames a chance to get through
+#define PKT_INPUT_RESEND_RATE 0.05
+
+typedef struct {
+    uint32_t seq; // NOTE(zaklaus): sequence of the newest frame
+    uint8_t frame_count;
+    pkt_input_frame frames[PKT_INPUT_REDUNDANCY]; // NOTE(zaklaus): oldest first
+} pkt_input_history;
 
 typedef pkt_send_keystate game_keystate_data;
 
-size_t pkt_send_keystate_send(uint16_t view_id,
-                              game_keystate_data *data);
+void   pkt_input_history_push(pkt_input_history *history, pkt_input_frame const *frame);
+size_t pkt_input_history_encode(pkt_ctx *ctx, pkt_input_history const *history);
+int32_t pkt_input_history_decode(pkt_header *header, pkt_input_history *history);
 
-size_t pkt_send_blockpos_send(uint16_t view_id,
-                              pkt_send_blockpos *data);
+size_t pkt_send_keystate_send(pkt_ctx *ctx,
+                              uint16_t view_id,
+                              game_keystate_data *data,
+                              float bx,
+                              float by);
+size_t pkt_send_keystate_resend(pkt_ctx *ctx, uint16_t view_id);
 
-extern pkt_desc pkt_send_keystate_desc[];
-extern pkt_desc pkt_send_blockpos_desc[];
+PKT_CODEC_DECLARE(pkt_send_keystate, pkt_send_keystate);
+PKT_CODEC_DECLARE_BITS(pkt_send_keystate, pkt_send_keystate);
 
 PKT_HANDLER_PROC(pkt_send_keystate_handler);
-PKT_HANDLER_PROC(pkt_send_blockpos_handler);
-
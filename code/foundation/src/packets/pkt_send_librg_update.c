@@ -3,23 +3,83 @@
 #include "packets/pkt_send_librg_update.h"
 #include "world/world.h"
 #include "core/game.h"
+#include "net/network.h"
 
-size_t pkt_send_librg_update(uint64_t peer_id,
+// NOTE(zaklaus): [uint8 layer_id, uint32 input_seq, bin32 data]
+#define PKT_LIBRG_UPDATE_RESERVE 13
+
+size_t pkt_send_librg_update(pkt_ctx *ctx,
+                             uint64_t peer_id,
                              uint16_t view_id,
                              uint8_t ticker,
+                             uint32_t input_seq,
+                             int8_t is_reliable,
                              void *data,
                              size_t datalen) {
-    return pkt_world_write(MSG_ID_LIBRG_UPDATE, pkt_send_librg_update_encode(data, (int32_t)datalen, ticker), 1, view_id, (void*)peer_id, 0);
+    pkt_header pkt;
+    uint8_t *buffer = pkt_send_librg_update_begin(ctx, &pkt, view_id, ticker, input_seq, is_reliable, datalen);
+    if (!buffer) return 0;
+    zpl_memcopy(buffer, data, datalen);
+    return pkt_send_librg_update_commit(&pkt, peer_id, datalen);
+}
+
+uint8_t *pkt_send_librg_update_begin(pkt_ctx *ctx, pkt_header *pkt, uint16_t view_id, uint8_t ticker, uint32_t input_seq, int8_t is_reliable, size_t capacity) {
+    // NOTE(zaklaus): every layer shares the welcome's channel, creates/updates/removes and handle reuse rely on its ordering
+    // enet holds unreliable updates back until the reliable stream before them arrived and drops them once a newer one did
+    uint8_t *payload = pkt_world_begin(ctx, pkt, MSG_ID_LIBRG_UPDATE, view_id, PKT_LIBRG_UPDATE_RESERVE + capacity, is_reliable, NETWORK_CHANNEL_WORLD);
+    if (!payload) return NULL;
+    payload[0] = 0x93;
+    payload[1] = 0xcc;
+    payload[2] = ticker;
+    payload[3] = 0xce;
+    payload[4] = (uint8_t)(input_seq >> 24);
+    payload[5] = (uint8_t)(input_seq >> 16);
+    payload[6] = (uint8_t)(input_seq >> 8);
+    payload[7] = (uint8_t)(input_seq);
+    payload[8] = 0xc6;
+    return payload + PKT_LIBRG_UPDATE_RESERVE;
+}
+
+size_t pkt_send_librg_update_commit(pkt_header *pkt, uint64_t peer_id, size_t datalen) {
+    uint8_t *payload = pkt->data + PKT_HEADER_RESERVE;
+    payload[9] = (uint8_t)(datalen >> 24);
+    payload[10] = (uint8_t)(datalen >> 16);
+    payload[11] = (uint8_t)(datalen >> 8);
+    payload[12] = (uint8_t)(datalen);
+    return pkt_world_commit(pkt, PKT_LIBRG_UPDATE_RESERVE + datalen, (void*)peer_id);
 }
 
-size_t pkt_send_librg_update_encode(void *data, int32_t data_length, uint8_t layer_id) {
+size_t pkt_send_librg_update_encode(pkt_ctx *ctx, void *data, int32_t data_length, uint8_t layer_id, uint32_t input_seq) {
     cw_pack_context pc = {0};
-    pkt_pack_msg(&pc, 2);
+    pkt_pack_msg(ctx, &pc, 3);
     cw_pack_unsigned(&pc, layer_id);
+    cw_pack_unsigned(&pc, input_seq);
     cw_pack_bin(&pc, data, data_length);
     return pkt_pack_msg_size(&pc);
 }
 
+int32_t pkt_send_librg_update_decode(pkt_header *header, uint8_t *layer_id, uint32_t *input_seq, void **data, size_t *datalen) {
+    cw_unpack_context uc = {0};
+    PKT_IF(pkt_unpack_msg(&uc, header, 3));
+
+    cw_unpack_next(&uc);
+    if (uc.item.type != CWP_ITEM_POSITIVE_INTEGER || uc.item.as.u64 > UINT8_MAX)
+        return -1;
+    *layer_id = (uint8_t)uc.item.as.u64;
+
+    cw_unpack_next(&uc);
+    if (uc.item.type != CWP_ITEM_POSITIVE_INTEGER || uc.item.as.u64 > UINT32_MAX)
+        return -1;
+    *input_seq = (uint32_t)uc.item.as.u64;
+
+    cw_unpack_next(&uc);
+    if (uc.item.type != CWP_ITEM_BIN)
+        return -1;
+    *data = (void*)uc.item.as.bin.start;
+    *datalen = uc.item.as.bin.length;
+    return 0;
+}
+
 #define NUM_SAMPLES 128
 
 static float smooth_time(float time) {
@@ -42,24 +102,20 @@ static float smooth_time(float time) {
 #undef NUM_SAMPLES
 
 int32_t pkt_send_librg_update_handler(pkt_header *header) {
-    cw_unpack_context uc = {0};
-    pkt_unpack_msg(&uc, header, 2);
-    cw_unpack_next(&uc);
-    
-    if (uc.item.type != CWP_ITEM_POSITIVE_INTEGER)
-        return -1;
-    
-    uint8_t layer_id = (uint8_t)uc.item.as.u64;
+    uint8_t layer_id = 0;
+    uint32_t input_seq = 0;
+    void *data = NULL;
+    size_t datalen = 0;
+    PKT_IF(pkt_send_librg_update_decode(header, &layer_id, &input_seq, &data, &datalen));
     
-    cw_unpack_next(&uc);
-    
-    if (uc.item.type != CWP_ITEM_BIN)
-        return -1;
-    
-    world_view *view = game_world_view_get(header->view_id);
+    return pkt_send_librg_update_apply(header->view_id, layer_id, data, datalen);
+}
+
+int32_t pkt_send_librg_update_apply(uint16_t view_id, uint8_t layer_id, void *data, size_t datalen) {
+    world_view *view = game_world_view_get(view_id);
     view->active_layer_id = layer_id;
     
-    int32_t state = librg_world_read(view->tracker, header->view_id, uc.item.as.bin.start, uc.item.as.bin.length, NULL);
+    int32_t state = world_view_read(view, data, datalen);
     if (state < 0) zpl_printf("[ERROR] world read error: %d\n", state);
     
     float now = (float)get_cached_time();
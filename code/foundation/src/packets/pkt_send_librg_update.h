@@ -2,12 +2,28 @@
 #include "platform/system.h"
 #include "pkt/packet_utils.h"
 
-size_t pkt_send_librg_update(uint64_t peer_id,
+// NOTE(zaklaus): input_seq echoes the last input frame the server applied for this viewer,
+// the update carries the state produced by that input
+size_t pkt_send_librg_update(pkt_ctx *ctx,
+                              uint64_t peer_id,
                               uint16_t view_id,
                               uint8_t ticker,
+                              uint32_t input_seq,
+                              int8_t is_reliable,
                               void *data,
                               size_t datalen);
-size_t pkt_send_librg_update_encode(void *data, int32_t data_length, uint8_t layer_id);
+size_t pkt_send_librg_update_encode(pkt_ctx *ctx, void *data, int32_t data_length, uint8_t layer_id, uint32_t input_seq);
+
+// NOTE(zaklaus): in-place variant, librg data is written straight into the returned buffer
+// streams carrying creates/removes must be reliable, update-only ones may go out unreliably
+uint8_t *pkt_send_librg_update_begin(pkt_ctx *ctx, pkt_header *pkt, uint16_t view_id, uint8_t ticker, uint32_t input_seq, int8_t is_reliable, size_t capacity);
+size_t pkt_send_librg_update_commit(pkt_header *pkt, uint64_t peer_id, size_t datalen);
+
+// NOTE(zaklaus): splits an update into its parts, data points into the packet
+int32_t pkt_send_librg_update_decode(pkt_header *header, uint8_t *layer_id, uint32_t *input_seq, void **data, size_t *datalen);
+
+// NOTE(zaklaus): feeds a world stream into the given viewer, used by the handler and direct transport
+int32_t pkt_send_librg_update_apply(uint16_t view_id, uint8_t layer_id, void *data, size_t datalen);
 
 PKT_HANDLER_PROC(pkt_send_librg_update_handler);
 
@@ -1,5 +1,6 @@
 #include "packets/pkt_send_notif.h"
 #include "pkt/packet.h"
+#include "net/network.h"
 #include "world/world.h"
 #include "core/game.h"
 #include "world/entity_view.h"
@@ -10,22 +11,23 @@
 // client
 #include "gui/notifications.h"
 
-pkt_desc pkt_send_notification_desc[] = {
-	{ PKT_ARRAY(pkt_send_notification, title) },
-	{ PKT_ARRAY(pkt_send_notification, text) },
-	{ PKT_END },
-};
+#define PKT_CODEC_NAME pkt_send_notification
+#define PKT_CODEC_TYPE pkt_send_notification
+#define PKT_CODEC_FIELDS(F, KEEP_IF, SKIP_IF, END_IF) \
+	F(ARRAY, title) \
+	F(ARRAY, text)
+#include "pkt/packet_codec.h"
 
-size_t pkt_notification_send(uint64_t peer_id, uint16_t view_id, const char *title, const char *text) {
+size_t pkt_notification_send(pkt_ctx *ctx, uint64_t peer_id, uint16_t view_id, const char *title, const char *text) {
 	pkt_send_notification table = { 0 };
 	zpl_strncpy(table.title, title, sizeof(table.title));
 	zpl_strncpy(table.text, text, sizeof(table.text));
-	return pkt_world_write(MSG_ID_SEND_NOTIFICATION, pkt_table_encode(pkt_send_notification_desc, PKT_STRUCT_PTR(&table)), 1, view_id, (void*)peer_id, 0);
+	return pkt_world_write(ctx, MSG_ID_SEND_NOTIFICATION, pkt_send_notification_encode(ctx, &table), 1, view_id, (void*)peer_id, NETWORK_CHANNEL_EVENTS);
 }
 
 int32_t pkt_send_notification_handler(pkt_header *header) {
 	pkt_send_notification table;
-	PKT_IF(pkt_msg_decode(header, pkt_send_notification_desc, pkt_pack_desc_args(pkt_send_notification_desc), PKT_STRUCT_PTR(&table)));
+	PKT_IF(pkt_send_notification_decode(header, &table));
 
 	notification_push(table.title, table.text);
 
@@ -7,8 +7,8 @@ typedef struct {
 	char text[1024];
 } pkt_send_notification;
 
-size_t pkt_notification_send(uint64_t peer_id, uint16_t view_id, const char *title, const char *text);
-extern pkt_desc pkt_send_notification_desc[];
+size_t pkt_notification_send(pkt_ctx *ctx, uint64_t peer_id, uint16_t view_id, const char *title, const char *text);
+PKT_CODEC_DECLARE(pkt_send_notification, pkt_send_notification);
 
 PKT_HANDLER_PROC(pkt_send_notification_handler);
 
@@ -10,19 +10,20 @@
 #include "models/components.h"
 #include "systems/systems.h"
 
-pkt_desc pkt_switch_viewer_desc[] = {
-    { PKT_FIELD(CWP_ITEM_POSITIVE_INTEGER, pkt_switch_viewer, view_id) },
-    { PKT_END },
-};
+#define PKT_CODEC_NAME pkt_switch_viewer
+#define PKT_CODEC_TYPE pkt_switch_viewer
+#define PKT_CODEC_FIELDS(F, KEEP_IF, SKIP_IF, END_IF) \
+    F(UINT, view_id)
+#include "pkt/packet_codec.h"
 
-size_t pkt_switch_viewer_send(uint16_t view_id) {
+size_t pkt_switch_viewer_send(pkt_ctx *ctx, uint16_t view_id) {
     pkt_switch_viewer table = {.view_id = view_id };
-    return pkt_world_write(MSG_ID_SWITCH_VIEWER, pkt_table_encode(pkt_switch_viewer_desc, PKT_STRUCT_PTR(&table)), 1, view_id, NULL, 1);
+    return pkt_world_write(ctx, MSG_ID_SWITCH_VIEWER, pkt_switch_viewer_encode(ctx, &table), 1, view_id, NULL, NETWORK_CHANNEL_INPUT);
 }
 
 int32_t pkt_switch_viewer_handler(pkt_header *header) {
     pkt_switch_viewer table;
-    PKT_IF(pkt_msg_decode(header, pkt_switch_viewer_desc, pkt_pack_desc_args(pkt_switch_viewer_desc), PKT_STRUCT_PTR(&table)));
+    PKT_IF(pkt_switch_viewer_decode(header, &table));
 
     ecs_entity_t e = network_server_get_entity(header->udata, header->view_id);
     uint64_t peer_id = (uint64_t)header->udata;
@@ -6,8 +6,8 @@ typedef struct {
     uint16_t view_id;
 } pkt_switch_viewer;
 
-size_t pkt_switch_viewer_send(uint16_t view_id);
-extern pkt_desc pkt_switch_viewer_desc[];
+size_t pkt_switch_viewer_send(pkt_ctx *ctx, uint16_t view_id);
+PKT_CODEC_DECLARE(pkt_switch_viewer, pkt_switch_viewer);
 
 PKT_HANDLER_PROC(pkt_switch_viewer_handler);
 
@@ -1,4 +1,5 @@
 #include "pkt/packet_utils.h"
+#include "pkt/packet_bits.h"
 #include "utils/compress.h"
 #include "cwpack/cwpack.h"
 
@@ -19,21 +20,72 @@ pkt_handler pkt_handlers[] = {
     {.id = MSG_ID_01_WELCOME, .handler = pkt_01_welcome_handler},
     {.id = MSG_ID_LIBRG_UPDATE, .handler = pkt_send_librg_update_handler},
     {.id = MSG_ID_SEND_KEYSTATE, .handler = pkt_send_keystate_handler},
-    {.id = MSG_ID_SEND_BLOCKPOS, .handler = pkt_send_blockpos_handler},
 	{.id = MSG_ID_SWITCH_VIEWER, .handler = pkt_switch_viewer_handler},
 	{.id = MSG_ID_SEND_NOTIFICATION, .handler = pkt_send_notification_handler},
 	{.id = MSG_ID_SEND_CODE, .handler = pkt_send_code_handler},
 };
 
-uint8_t pkt_buffer[PKT_BUFSIZ];
+static zpl_thread_local pkt_ctx *pkt_local_ctx = NULL;
 
-int32_t pkt_header_encode(pkt_messages id, uint16_t view_id, void *data, size_t datalen) {
-    cw_pack_context pc = {0};
-    pkt_pack_msg(&pc, PKT_HEADER_ELEMENTS);
-    cw_pack_unsigned(&pc, id);
-    cw_pack_unsigned(&pc, view_id);
-    cw_pack_bin(&pc, data, (uint32_t)datalen);
-    return (int32_t)pkt_pack_msg_size(&pc);
+// NOTE(zaklaus): every context handed out by pkt_ctx_local, freed in one go on shutdown
+static zpl_atomic32 pkt_local_lock = {0};
+static zpl_array(pkt_ctx*) pkt_local_ctxs = NULL;
+
+pkt_ctx *pkt_ctx_create(void) {
+    pkt_ctx *ctx = zpl_malloc(sizeof(pkt_ctx));
+    ctx->buffer = zpl_malloc(PKT_BUFSIZ);
+    ctx->bin_buf = zpl_malloc(PKT_BUFSIZ);
+    return ctx;
+}
+
+void pkt_ctx_destroy(pkt_ctx *ctx) {
+    if (!ctx) return;
+    zpl_mfree(ctx->buffer);
+    zpl_mfree(ctx->bin_buf);
+    zpl_mfree(ctx);
+}
+
+pkt_ctx *pkt_ctx_local(void) {
+    if (!pkt_local_ctx) {
+        pkt_local_ctx = pkt_ctx_create();
+
+        zpl_atomic32_spin_lock(&pkt_local_lock, -1);
+        if (!pkt_local_ctxs) {
+            zpl_array_init(pkt_local_ctxs, zpl_heap());
+        }
+        zpl_array_append(pkt_local_ctxs, pkt_local_ctx);
+        zpl_atomic32_spin_unlock(&pkt_local_lock);
+    }
+    return pkt_local_ctx;
+}
+
+void pkt_ctx_local_destroy_all(void) {
+    zpl_atomic32_spin_lock(&pkt_local_lock, -1);
+    if (pkt_local_ctxs) {
+        for (zpl_isize i = 0; i < zpl_array_count(pkt_local_ctxs); i += 1) {
+            pkt_ctx_destroy(pkt_local_ctxs[i]);
+        }
+        zpl_array_free(pkt_local_ctxs);
+        pkt_local_ctxs = NULL;
+    }
+    pkt_local_ctx = NULL;
+    zpl_atomic32_spin_unlock(&pkt_local_lock);
+}
+
+void pkt_header_encode_inplace(uint8_t *dst, pkt_messages id, uint16_t view_id, size_t datalen) {
+    // NOTE(zaklaus): [uint16 id, uint16 view_id, bin32 data], always PKT_HEADER_RESERVE bytes long
+    dst[0] = 0x90 | PKT_HEADER_ELEMENTS;
+    dst[1] = 0xcd;
+    dst[2] = (uint8_t)(id >> 8);
+    dst[3] = (uint8_t)(id);
+    dst[4] = 0xcd;
+    dst[5] = (uint8_t)(view_id >> 8);
+    dst[6] = (uint8_t)(view_id);
+    dst[7] = 0xc6;
+    dst[8] = (uint8_t)(datalen >> 24);
+    dst[9] = (uint8_t)(datalen >> 16);
+    dst[10] = (uint8_t)(datalen >> 8);
+    dst[11] = (uint8_t)(datalen);
 }
 
 int32_t pkt_header_decode(pkt_header *table, void *data, size_t datalen) {
@@ -67,7 +119,7 @@ int32_t pkt_header_decode(pkt_header *table, void *data, size_t datalen) {
     return pkt_validate_eof_msg(&uc) != -1;
 }
 
-int32_t pkt_unpack_struct(cw_unpack_context *uc, pkt_desc *desc, void *raw_blob, uint32_t blob_size) {
+int32_t pkt_unpack_struct(pkt_ctx *ctx, cw_unpack_context *uc, pkt_desc *desc, void *raw_blob, uint32_t blob_size) {
     uint8_t *blob = (uint8_t*)raw_blob;
     for (pkt_desc *field = desc; field->type != CWP_NOT_AN_ITEM; ++field) {
         cw_unpack_next(uc);
@@ -92,11 +144,7 @@ int32_t pkt_unpack_struct(cw_unpack_context *uc, pkt_desc *desc, void *raw_blob,
                 zpl_memcopy(blob + field->offset, (uint8_t*)&uc->item.as.u64, field->size);
             }break;
             case CWP_ITEM_BIN: {
-                if (uc->item.as.bin.length >= PKT_BUFSIZ) return -1; // bin blob too big
-                static uint8_t bin_buf[PKT_BUFSIZ] = {0};
-                uint32_t actual_size = decompress_rle((void *)uc->item.as.bin.start, uc->item.as.bin.length, bin_buf);
-                if (actual_size != field->size) return -1; // bin size mismatch
-                zpl_memcopy(blob + field->offset, bin_buf, actual_size);
+                PKT_IF(pkt_unpack_array(ctx, uc, blob + field->offset, (uint32_t)field->size));
             }break;
             default: {
                 zpl_printf("[WARN] unsupported pkt field type %lld !\n", field->type);
@@ -108,7 +156,7 @@ int32_t pkt_unpack_struct(cw_unpack_context *uc, pkt_desc *desc, void *raw_blob,
     return 0;
 }
 
-int32_t pkt_pack_struct(cw_pack_context *pc, pkt_desc *desc, void *raw_blob, uint32_t blob_size) {
+int32_t pkt_pack_struct(pkt_ctx *ctx, cw_pack_context *pc, pkt_desc *desc, void *raw_blob, uint32_t blob_size) {
     (void)blob_size;
     uint8_t *blob = (uint8_t*)raw_blob;
     for (pkt_desc *field = desc; field->type != CWP_NOT_AN_ITEM; ++field) {
@@ -127,28 +175,25 @@ int32_t pkt_pack_struct(cw_pack_context *pc, pkt_desc *desc, void *raw_blob, uin
 
         switch (field->type) {
             case CWP_ITEM_BIN: {
-                if (field->size >= PKT_BUFSIZ) return -1; // bin blob too big
-                static uint8_t bin_buf[PKT_BUFSIZ] = {0};
-                uint32_t size = compress_rle((void *)(blob + field->offset), (uint32_t)field->size, bin_buf);
-                cw_pack_bin(pc, bin_buf, size);
+                PKT_IF(pkt_pack_array(ctx, pc, blob + field->offset, (uint32_t)field->size));
             }break;
             case CWP_ITEM_POSITIVE_INTEGER: {
-                uint64_t num;
+                uint64_t num = 0;
                 zpl_memcopy(&num, blob + field->offset, field->size);
                 cw_pack_unsigned(pc, num);
             }break;
             case CWP_ITEM_NEGATIVE_INTEGER: {
-                int64_t num;
+                int64_t num = 0;
                 zpl_memcopy(&num, blob + field->offset, field->size);
                 cw_pack_signed(pc, num);
             }break;
             case CWP_ITEM_DOUBLE: {
-                double num;
+                double num = 0;
                 zpl_memcopy(&num, blob + field->offset, field->size);
                 cw_pack_double(pc, num);
             }break;
             case CWP_ITEM_FLOAT: {
-                float num;
+                float num = 0;
                 zpl_memcopy(&num, blob + field->offset, field->size);
                 cw_pack_float(pc, num);
             }break;
@@ -162,6 +207,43 @@ int32_t pkt_pack_struct(cw_pack_context *pc, pkt_desc *desc, void *raw_blob, uin
     return 0;
 }
 
+int32_t pkt_unpack_array(pkt_ctx *ctx, cw_unpack_context *uc, void *dst, uint32_t size) {
+    (void)ctx;
+    // NOTE(zaklaus): decompression is bounds-checked, expand straight into the field
+    int32_t actual_size = decompress_rle(uc->item.as.bin.start, uc->item.as.bin.length, dst, size);
+    if (actual_size != (int32_t)size) return -1; // bin size mismatch
+    return 0;
+}
+
+int32_t pkt_pack_array(pkt_ctx *ctx, cw_pack_context *pc, void const *src, uint32_t size) {
+    int32_t packed_size = compress_rle(src, size, ctx->bin_buf, PKT_BUFSIZ);
+    if (packed_size < 0) return -1; // bin blob too big
+    cw_pack_bin(pc, ctx->bin_buf, (uint32_t)packed_size);
+    return 0;
+}
+
+int32_t pkt_bits_pack_array(pkt_ctx *ctx, pkt_bits *bs, void const *src, uint32_t size) {
+    int32_t packed_size = compress_rle(src, size, ctx->bin_buf, PKT_BUFSIZ);
+    if (packed_size < 0) return bs->error = -1; // bin blob too big
+    pkt_bits_write_varint(bs, (uint64_t)packed_size);
+    pkt_bits_write_align(bs);
+    if (bs->error || (uint32_t)packed_size > bs->size - bs->pos) return bs->error = -1;
+    zpl_memcopy(bs->data + bs->pos, ctx->bin_buf, packed_size);
+    bs->pos += (uint32_t)packed_size;
+    return 0;
+}
+
+int32_t pkt_bits_unpack_array(pkt_ctx *ctx, pkt_bits *bs, void *dst, uint32_t size) {
+    (void)ctx;
+    uint64_t packed_size = pkt_bits_read_varint(bs);
+    pkt_bits_read_align(bs);
+    if (bs->error || packed_size > bs->size - bs->pos) return bs->error = -1;
+    int32_t actual_size = decompress_rle(bs->data + bs->pos, (uint32_t)packed_size, dst, size);
+    if (actual_size != (int32_t)size) return bs->error = -1; // bin size mismatch
+    bs->pos += (uint32_t)packed_size;
+    return 0;
+}
+
 void pkt_dump_struct(pkt_desc *desc, void* raw_blob, uint32_t blob_size) {
     (void)blob_size;
     uint8_t *blob = (uint8_t*)raw_blob;
@@ -3,12 +3,19 @@
 
 #define PKT_BUFSIZ 4000000
 
+// NOTE(zaklaus): fixed-width header, lets us write payloads in place before their size is known
+#define PKT_HEADER_RESERVE 12
+
+// NOTE(zaklaus): coalesced datagrams start with a byte msgpack never uses,
+// followed by [u16 length (little-endian), message] frames
+#define PKT_BATCH_MARKER 0xc1
+#define PKT_BATCH_FRAME_SIZE 2
+
 typedef enum {
     MSG_ID_00_INIT,
     MSG_ID_01_WELCOME,
     MSG_ID_LIBRG_UPDATE,
     MSG_ID_SEND_KEYSTATE,
-    MSG_ID_SEND_BLOCKPOS,
 	MSG_ID_SWITCH_VIEWER,
 	MSG_ID_SEND_NOTIFICATION,
 	MSG_ID_SEND_CODE,
@@ -16,6 +23,22 @@ typedef enum {
     MAX_PACKETS = 256,
 } pkt_messages;
 
+// NOTE(zaklaus): scratch memory used while encoding/decoding messages,
+// every thread that builds packets needs its own context
+typedef struct pkt_ctx {
+    uint8_t *buffer;  // message payload
+    uint8_t *bin_buf; // RLE-compressed bin fields
+} pkt_ctx;
+
+pkt_ctx *pkt_ctx_create(void);
+void pkt_ctx_destroy(pkt_ctx *ctx);
+
+// NOTE(zaklaus): context owned by the calling thread, created on first use
+pkt_ctx *pkt_ctx_local(void);
+
+// NOTE(zaklaus): frees the contexts of all threads, call once the other threads are joined
+void pkt_ctx_local_destroy_all(void);
+
 typedef struct pkt_header {
     uint16_t id;
     uint16_t sender;
@@ -26,6 +49,8 @@ typedef struct pkt_header {
     int8_t is_reliable;
     int8_t ok;
     void* udata;
+    void* packet; // NOTE(zaklaus): transport-owned buffer, if any
+    pkt_ctx* ctx;
 } pkt_header;
 
 #define PKT_HANDLER_PROC(name) int32_t name(pkt_header *header)
@@ -36,8 +61,7 @@ typedef struct {
     pkt_handler_proc *handler;
 } pkt_handler;
 
-int32_t pkt_header_encode(pkt_messages id, uint16_t view_id, void *data, size_t datalen);
 int32_t pkt_header_decode(pkt_header *table, void *data, size_t datalen);
+void pkt_header_encode_inplace(uint8_t *dst, pkt_messages id, uint16_t view_id, size_t datalen);
 
 extern pkt_handler pkt_handlers[];
-extern uint8_t pkt_buffer[];
@@ -0,0 +1,104 @@
+#pragma once
+#include "platform/system.h"
+#include "pkt/packet.h"
+
+// NOTE(zaklaus): LSB-first bitstream, used by codecs that opt into PKT_CODEC_BITS
+//
+// Booleans and skip flags take a single bit, unsigned integers are written as
+// varints made of [continue:1, value:4] groups and floats carry a one-bit zero marker.
+// Errors are sticky, check pkt_bits::error once the whole message went through and
+// call pkt_bits_flush after the last write.
+
+typedef struct pkt_bits {
+    uint8_t *data;
+    uint32_t size;
+    uint32_t pos;          // bytes moved in/out of data so far
+    uint64_t scratch;      // pending bits, LSB first
+    uint32_t scratch_bits;
+    int32_t error;
+} pkt_bits;
+
+#define PKT_BITS_VARINT_GROUP 4
+
+static inline void pkt_bits_init(pkt_bits *bs, void *data, uint32_t size) {
+    zpl_zero_item(bs);
+    bs->data = (uint8_t*)data;
+    bs->size = size;
+}
+
+static inline void pkt_bits__flush_bytes(pkt_bits *bs, uint32_t num_bytes) {
+    if (bs->size - bs->pos < num_bytes) {
+        bs->error = -1;
+        bs->scratch = 0;
+        bs->scratch_bits = 0;
+        return;
+    }
+    for (uint32_t i = 0; i < num_bytes; i++) {
+        bs->data[bs->pos++] = (uint8_t)bs->scratch;
+        bs->scratch >>= 8;
+    }
+    bs->scratch_bits = bs->scratch_bits > num_bytes * 8 ? bs->scratch_bits - num_bytes * 8 : 0;
+}
+
+// NOTE(zaklaus): up to 32 bits at a time
+static inline void pkt_bits_write(pkt_bits *bs, uint64_t value, uint32_t num_bits) {
+    bs->scratch |= (value & ((1ull << num_bits) - 1)) << bs->scratch_bits;
+    bs->scratch_bits += num_bits;
+    if (bs->scratch_bits >= 32) pkt_bits__flush_bytes(bs, 4);
+}
+
+// NOTE(zaklaus): writes out the pending bits, padding the last byte with zeroes
+static inline void pkt_bits_flush(pkt_bits *bs) {
+    pkt_bits__flush_bytes(bs, (bs->scratch_bits + 7) >> 3);
+}
+
+// NOTE(zaklaus): up to 32 bits at a time
+static inline uint64_t pkt_bits_read(pkt_bits *bs, uint32_t num_bits) {
+    while (bs->scratch_bits < num_bits) {
+        if (bs->pos >= bs->size) {
+            bs->error = -1;
+            return 0;
+        }
+        bs->scratch |= (uint64_t)bs->data[bs->pos++] << bs->scratch_bits;
+        bs->scratch_bits += 8;
+    }
+    uint64_t value = bs->scratch & ((1ull << num_bits) - 1);
+    bs->scratch >>= num_bits;
+    bs->scratch_bits -= num_bits;
+    return value;
+}
+
+static inline void pkt_bits_write_varint(pkt_bits *bs, uint64_t value) {
+    for (;;) {
+        uint64_t group = value & ((1u << PKT_BITS_VARINT_GROUP) - 1);
+        value >>= PKT_BITS_VARINT_GROUP;
+        pkt_bits_write(bs, (group << 1) | (value != 0), PKT_BITS_VARINT_GROUP + 1);
+        if (!value) break;
+    }
+}
+
+static inline uint64_t pkt_bits_read_varint(pkt_bits *bs) {
+    uint64_t value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += PKT_BITS_VARINT_GROUP) {
+        uint64_t group = pkt_bits_read(bs, PKT_BITS_VARINT_GROUP + 1);
+        value |= (group >> 1) << shift;
+        if (!(group & 1) || bs->error) return value;
+    }
+    bs->error = -1; // varint too long
+    return value;
+}
+
+// NOTE(zaklaus): moves the stream to a byte boundary, afterwards pos points at the next raw byte
+static inline void pkt_bits_write_align(pkt_bits *bs) {
+    pkt_bits_flush(bs);
+}
+
+static inline void pkt_bits_read_align(pkt_bits *bs) {
+    bs->pos -= bs->scratch_bits >> 3;
+    bs->scratch = 0;
+    bs->scratch_bits = 0;
+}
+
+// NOTE(zaklaus): RLE-compressed bin fields, stored byte-aligned after a varint length
+int32_t pkt_bits_pack_array(pkt_ctx *ctx, pkt_bits *bs, void const *src, uint32_t size);
+int32_t pkt_bits_unpack_array(pkt_ctx *ctx, pkt_bits *bs, void *dst, uint32_t size);
@@ -0,0 +1,165 @@
+// NOTE(zaklaus): packet codec generator, include once per message type
+//
+// #define PKT_CODEC_NAME pkt_my_msg
+// #define PKT_CODEC_TYPE pkt_my_msg
+// #define PKT_CODEC_FIELDS(F, KEEP_IF, SKIP_IF, END_IF) F(UINT, kind) KEEP_IF(kind, 0, 2) F(HALF, x) F(HALF, y) END_IF
+// #include "pkt/packet_codec.h"
+//
+// Expands the field list into straight-line <name>_pack/_unpack/_encode/_decode functions
+// and the matching <name>_desc table. Both produce the same wire format, define
+// PKT_CODEC_TABLE_DRIVEN to route the generated functions through the table for debugging.
+//
+// Define PKT_CODEC_BITS to 1 to also get <name>_pack_bits/_unpack_bits, which write the
+// same fields into a pkt_bits stream instead of msgpack.
+
+#ifndef PKT_CODEC_NAME
+#error "PKT_CODEC_NAME has to be defined before including packet_codec.h"
+#endif
+
+#ifndef PKT_CODEC_TYPE
+#error "PKT_CODEC_TYPE has to be defined before including packet_codec.h"
+#endif
+
+#ifndef PKT_CODEC_FIELDS
+#error "PKT_CODEC_FIELDS has to be defined before including packet_codec.h"
+#endif
+
+#ifndef PKT_CODEC__HELPERS
+#define PKT_CODEC__HELPERS
+
+#include "pkt/packet_bits.h"
+
+#define PKT_CODEC__JOIN2(a, b) a##b
+#define PKT_CODEC__JOIN(a, b) PKT_CODEC__JOIN2(a, b)
+#define PKT_CODEC__FN(suffix) PKT_CODEC__JOIN(PKT_CODEC_NAME, suffix)
+
+// NOTE(zaklaus): table entries
+#define PKT_CODEC__DESC_F(k, a) { PKT_##k(PKT_CODEC_TYPE, a) },
+#define PKT_CODEC__DESC_KEEP_IF(a, e, n) { PKT_KEEP_IF(PKT_CODEC_TYPE, a, e, n) },
+#define PKT_CODEC__DESC_SKIP_IF(a, e, n) { PKT_SKIP_IF(PKT_CODEC_TYPE, a, e, n) },
+#define PKT_CODEC__DESC_END_IF
+
+// NOTE(zaklaus): top-level element count
+#define PKT_CODEC__ARGS_F(k, a) + 1
+#define PKT_CODEC__ARGS_IF(a, e, n) + 1
+#define PKT_CODEC__ARGS_END_IF
+#define PKT_CODEC__NUM_ARGS (0 PKT_CODEC_FIELDS(PKT_CODEC__ARGS_F, PKT_CODEC__ARGS_IF, PKT_CODEC__ARGS_IF, PKT_CODEC__ARGS_END_IF))
+
+// NOTE(zaklaus): encoding, values are widened the same way pkt_pack_struct does it
+#define PKT_CODEC__PACK_F(k, a) PKT_CODEC__PACK_##k(pkt__s->a)
+#define PKT_CODEC__PACK_UINT(v) { uint64_t num = 0; memcpy(&num, &(v), sizeof(v)); cw_pack_unsigned(pc, num); }
+#define PKT_CODEC__PACK_SINT(v) { int64_t num = 0; memcpy(&num, &(v), sizeof(v)); cw_pack_signed(pc, num); }
+#define PKT_CODEC__PACK_REAL(v) { double num = 0; memcpy(&num, &(v), sizeof(v)); cw_pack_double(pc, num); }
+#define PKT_CODEC__PACK_HALF(v) { float num = 0; memcpy(&num, &(v), sizeof(v)); cw_pack_float(pc, num); }
+#define PKT_CODEC__PACK_BOOL(v) PKT_CODEC__PACK_UINT(v)
+#define PKT_CODEC__PACK_ARRAY(v) PKT_IF(pkt_pack_array(ctx, pc, &(v), (uint32_t)sizeof(v)));
+#define PKT_CODEC__PACK_KEEP_IF(a, e, n) \
+    if (*(uint8_t*)&pkt__s->a != (uint8_t)(e)) { cw_pack_unsigned(pc, n); } else { cw_pack_unsigned(pc, 0);
+#define PKT_CODEC__PACK_SKIP_IF(a, e, n) \
+    if (*(uint8_t*)&pkt__s->a == (uint8_t)(e)) { cw_pack_unsigned(pc, n); } else { cw_pack_unsigned(pc, 0);
+#define PKT_CODEC__PACK_END_IF }
+
+// NOTE(zaklaus): decoding
+#define PKT_CODEC__UNPACK_ITEM(t) cw_unpack_next(uc); if (uc->item.type != (t)) return -1;
+#define PKT_CODEC__UNPACK_F(k, a) PKT_CODEC__UNPACK_##k(pkt__s->a)
+#define PKT_CODEC__UNPACK_UINT(v) { PKT_CODEC__UNPACK_ITEM(CWP_ITEM_POSITIVE_INTEGER) memcpy(&(v), &uc->item.as.u64, sizeof(v)); }
+#define PKT_CODEC__UNPACK_SINT(v) { PKT_CODEC__UNPACK_ITEM(CWP_ITEM_NEGATIVE_INTEGER) memcpy(&(v), &uc->item.as.i64, sizeof(v)); }
+#define PKT_CODEC__UNPACK_REAL(v) { PKT_CODEC__UNPACK_ITEM(CWP_ITEM_DOUBLE) memcpy(&(v), &uc->item.as.long_real, sizeof(v)); }
+#define PKT_CODEC__UNPACK_HALF(v) { PKT_CODEC__UNPACK_ITEM(CWP_ITEM_FLOAT) memcpy(&(v), &uc->item.as.real, sizeof(v)); }
+#define PKT_CODEC__UNPACK_BOOL(v) PKT_CODEC__UNPACK_UINT(v)
+#define PKT_CODEC__UNPACK_ARRAY(v) { PKT_CODEC__UNPACK_ITEM(CWP_ITEM_BIN) PKT_IF(pkt_unpack_array(ctx, uc, &(v), (uint32_t)sizeof(v))); }
+#define PKT_CODEC__UNPACK_IF(a, e, n) { \
+    PKT_CODEC__UNPACK_ITEM(CWP_ITEM_POSITIVE_INTEGER) \
+    if (uc->item.as.u64 != 0 && uc->item.as.u64 != (n)) return -1; \
+    if (uc->item.as.u64 == 0) {
+#define PKT_CODEC__UNPACK_END_IF } }
+
+// NOTE(zaklaus): bitstream encoding
+#define PKT_CODEC__BITS_PACK_F(k, a) PKT_CODEC__BITS_PACK_##k(pkt__s->a)
+#define PKT_CODEC__BITS_PACK_UINT(v) { uint64_t num = 0; memcpy(&num, &(v), sizeof(v)); pkt_bits_write_varint(bs, num); }
+#define PKT_CODEC__BITS_PACK_SINT(v) { int64_t num = 0; memcpy(&num, &(v), sizeof(v)); \
+    pkt_bits_write_varint(bs, ((uint64_t)num << 1) ^ (uint64_t)(num >> 63)); }
+#define PKT_CODEC__BITS_PACK_BOOL(v) { uint64_t num = 0; memcpy(&num, &(v), sizeof(v)); pkt_bits_write(bs, num != 0, 1); }
+#define PKT_CODEC__BITS_PACK_REAL(v) { uint64_t num = 0; memcpy(&num, &(v), sizeof(v)); \
+    pkt_bits_write(bs, num != 0, 1); if (num) { pkt_bits_write(bs, num, 32); pkt_bits_write(bs, num >> 32, 32); } }
+#define PKT_CODEC__BITS_PACK_HALF(v) { uint32_t num = 0; memcpy(&num, &(v), sizeof(v)); \
+    pkt_bits_write(bs, num != 0, 1); if (num) pkt_bits_write(bs, num, 32); }
+#define PKT_CODEC__BITS_PACK_ARRAY(v) PKT_IF(pkt_bits_pack_array(ctx, bs, &(v), (uint32_t)sizeof(v)));
+#define PKT_CODEC__BITS_PACK_KEEP_IF(a, e, n) \
+    pkt_bits_write(bs, *(uint8_t*)&pkt__s->a != (uint8_t)(e), 1); if (*(uint8_t*)&pkt__s->a == (uint8_t)(e)) {
+#define PKT_CODEC__BITS_PACK_SKIP_IF(a, e, n) \
+    pkt_bits_write(bs, *(uint8_t*)&pkt__s->a == (uint8_t)(e), 1); if (*(uint8_t*)&pkt__s->a != (uint8_t)(e)) {
+#define PKT_CODEC__BITS_PACK_END_IF }
+
+// NOTE(zaklaus): bitstream decoding
+#define PKT_CODEC__BITS_UNPACK_F(k, a) PKT_CODEC__BITS_UNPACK_##k(pkt__s->a)
+#define PKT_CODEC__BITS_UNPACK_UINT(v) { uint64_t num = pkt_bits_read_varint(bs); memcpy(&(v), &num, sizeof(v)); }
+#define PKT_CODEC__BITS_UNPACK_SINT(v) { uint64_t zz = pkt_bits_read_varint(bs); \
+    int64_t num = (int64_t)(zz >> 1) ^ -(int64_t)(zz & 1); memcpy(&(v), &num, sizeof(v)); }
+#define PKT_CODEC__BITS_UNPACK_BOOL(v) { uint64_t num = pkt_bits_read(bs, 1); memcpy(&(v), &num, sizeof(v)); }
+#define PKT_CODEC__BITS_UNPACK_REAL(v) { uint64_t num = 0; if (pkt_bits_read(bs, 1)) { \
+    num = pkt_bits_read(bs, 32); num |= pkt_bits_read(bs, 32) << 32; } memcpy(&(v), &num, sizeof(v)); }
+#define PKT_CODEC__BITS_UNPACK_HALF(v) { uint32_t num = 0; if (pkt_bits_read(bs, 1)) num = (uint32_t)pkt_bits_read(bs, 32); memcpy(&(v), &num, sizeof(v)); }
+#define PKT_CODEC__BITS_UNPACK_ARRAY(v) PKT_IF(pkt_bits_unpack_array(ctx, bs, &(v), (uint32_t)sizeof(v)));
+#define PKT_CODEC__BITS_UNPACK_IF(a, e, n) if (!pkt_bits_read(bs, 1)) {
+#define PKT_CODEC__BITS_UNPACK_END_IF }
+
+#endif // PKT_CODEC__HELPERS
+
+pkt_desc PKT_CODEC__FN(_desc)[] = {
+    PKT_CODEC_FIELDS(PKT_CODEC__DESC_F, PKT_CODEC__DESC_KEEP_IF, PKT_CODEC__DESC_SKIP_IF, PKT_CODEC__DESC_END_IF)
+    { PKT_END },
+};
+
+#if PKT_CODEC_TABLE_DRIVEN
+int32_t PKT_CODEC__FN(_pack)(pkt_ctx *ctx, cw_pack_context *pc, PKT_CODEC_TYPE const *pkt__s) {
+    return pkt_pack_struct(ctx, pc, PKT_CODEC__FN(_desc), (void*)pkt__s, (uint32_t)sizeof(*pkt__s));
+}
+
+int32_t PKT_CODEC__FN(_unpack)(pkt_ctx *ctx, cw_unpack_context *uc, PKT_CODEC_TYPE *pkt__s) {
+    return pkt_unpack_struct(ctx, uc, PKT_CODEC__FN(_desc), PKT_STRUCT_PTR(pkt__s));
+}
+#else
+int32_t PKT_CODEC__FN(_pack)(pkt_ctx *ctx, cw_pack_context *pc, PKT_CODEC_TYPE const *pkt__s) {
+    (void)ctx;
+    PKT_CODEC_FIELDS(PKT_CODEC__PACK_F, PKT_CODEC__PACK_KEEP_IF, PKT_CODEC__PACK_SKIP_IF, PKT_CODEC__PACK_END_IF)
+    return 0;
+}
+
+int32_t PKT_CODEC__FN(_unpack)(pkt_ctx *ctx, cw_unpack_context *uc, PKT_CODEC_TYPE *pkt__s) {
+    (void)ctx;
+    PKT_CODEC_FIELDS(PKT_CODEC__UNPACK_F, PKT_CODEC__UNPACK_IF, PKT_CODEC__UNPACK_IF, PKT_CODEC__UNPACK_END_IF)
+    return 0;
+}
+#endif
+
+size_t PKT_CODEC__FN(_encode)(pkt_ctx *ctx, PKT_CODEC_TYPE const *pkt__s) {
+    cw_pack_context pc = {0};
+    pkt_pack_msg(ctx, &pc, PKT_CODEC__NUM_ARGS);
+    PKT_CODEC__FN(_pack)(ctx, &pc, pkt__s);
+    return pkt_pack_msg_size(&pc);
+}
+
+int32_t PKT_CODEC__FN(_decode)(pkt_header *header, PKT_CODEC_TYPE *pkt__s) {
+    cw_unpack_context uc = {0};
+    PKT_IF(pkt_unpack_msg(&uc, header, PKT_CODEC__NUM_ARGS));
+    PKT_IF(PKT_CODEC__FN(_unpack)(header->ctx, &uc, pkt__s));
+    return pkt_validate_eof_msg(&uc);
+}
+
+#if PKT_CODEC_BITS
+int32_t PKT_CODEC__FN(_pack_bits)(pkt_ctx *ctx, pkt_bits *bs, PKT_CODEC_TYPE const *pkt__s) {
+    PKT_CODEC_FIELDS(PKT_CODEC__BITS_PACK_F, PKT_CODEC__BITS_PACK_KEEP_IF, PKT_CODEC__BITS_PACK_SKIP_IF, PKT_CODEC__BITS_PACK_END_IF)
+    return bs->error;
+}
+
+int32_t PKT_CODEC__FN(_unpack_bits)(pkt_ctx *ctx, pkt_bits *bs, PKT_CODEC_TYPE *pkt__s) {
+    PKT_CODEC_FIELDS(PKT_CODEC__BITS_UNPACK_F, PKT_CODEC__BITS_UNPACK_IF, PKT_CODEC__BITS_UNPACK_IF, PKT_CODEC__BITS_UNPACK_END_IF)
+    return bs->error;
+}
+#endif
+
+#undef PKT_CODEC_NAME
+#undef PKT_CODEC_TYPE
+#undef PKT_CODEC_FIELDS
+#undef PKT_CODEC_BITS
@@ -7,8 +7,8 @@
 #define PKT_IF(c) if (c < 0) return -1;
 #endif
 
-static inline void pkt_pack_msg(cw_pack_context *pc, uint32_t args) {
-    cw_pack_context_init(pc, pkt_buffer, PKT_BUFSIZ, 0);
+static inline void pkt_pack_msg(pkt_ctx *ctx, cw_pack_context *pc, uint32_t args) {
+    cw_pack_context_init(pc, ctx->buffer, PKT_BUFSIZ, 0);
     cw_pack_array_size(pc, args);
 }
 
@@ -39,26 +39,40 @@ static inline size_t pkt_pack_msg_size(cw_pack_context *pc) {
     return pc->current - pc->start; // NOTE(zaklaus): length
 }
 
-static inline int32_t pkt_prep_msg(pkt_header *pkt, pkt_messages id, uint16_t view_id, size_t pkt_size, int8_t is_reliable, uint16_t channel_id) {
+extern int32_t world_write(pkt_header *pkt, void *udata);
+extern uint8_t *world_alloc(pkt_header *pkt, size_t size);
+
+// NOTE(zaklaus): in-place packet building
+// pkt_world_begin reserves header space and returns the payload area, which lives in the
+// transport's own buffer when there is one. pkt_world_commit fills in the header and sends it.
+static inline uint8_t *pkt_world_begin(pkt_ctx *ctx, pkt_header *pkt, pkt_messages id, uint16_t view_id, size_t capacity, int8_t is_reliable, uint16_t channel_id) {
     zpl_zero_item(pkt);
-    static uint8_t pkt_data[PKT_BUFSIZ] = {0};
-    zpl_memcopy(pkt_data, pkt_buffer, pkt_size);
-    
-    pkt->data = pkt_buffer;
+    pkt->ctx = ctx;
+    pkt->id = id;
     pkt->view_id = view_id;
-    pkt->datalen = pkt_header_encode(id, view_id, pkt_data, pkt_size);
     pkt->is_reliable = is_reliable;
     pkt->channel_id = channel_id;
-    pkt->id = id;
-    return 0;
+    pkt->data = world_alloc(pkt, PKT_HEADER_RESERVE + capacity);
+    return pkt->data ? pkt->data + PKT_HEADER_RESERVE : NULL;
 }
 
-extern int32_t world_write(pkt_header *pkt, void *udata);
+static inline int32_t pkt_world_commit(pkt_header *pkt, size_t pkt_size, void *udata) {
+    pkt_header_encode_inplace(pkt->data, (pkt_messages)pkt->id, pkt->view_id, pkt_size);
+    pkt->datalen = (uint32_t)(PKT_HEADER_RESERVE + pkt_size);
+    return world_write(pkt, udata);
+}
 
-static inline int32_t pkt_world_write(pkt_messages id, size_t pkt_size, int8_t is_reliable, uint16_t view_id, void *udata, uint16_t channel_id) {
+static inline void pkt_world_abort(pkt_header *pkt) {
+    world_alloc(pkt, 0);
+    pkt->data = NULL;
+}
+
+static inline int32_t pkt_world_write(pkt_ctx *ctx, pkt_messages id, size_t pkt_size, int8_t is_reliable, uint16_t view_id, void *udata, uint16_t channel_id) {
     pkt_header pkt;
-    PKT_IF(pkt_prep_msg(&pkt, id, view_id, pkt_size, is_reliable, channel_id));
-    return world_write(&pkt, udata);
+    uint8_t *payload = pkt_world_begin(ctx, &pkt, id, view_id, pkt_size, is_reliable, channel_id);
+    if (!payload) return -1;
+    zpl_memmove(payload, ctx->buffer, pkt_size);
+    return pkt_world_commit(&pkt, pkt_size, udata);
 }
 
 #ifndef PKT_OFFSETOF
@@ -86,6 +100,11 @@ static inline int32_t pkt_world_write(pkt_messages id, size_t pkt_size, int8_t i
 #define PKT_SINT(t, a) .type = CWP_ITEM_NEGATIVE_INTEGER, .offset = PKT_OFFSETOF(t, a), .size = PKT_FIELD_SIZEOF(t,a), .it_size = PKT_FIELD_SIZEOF(t,a), .name = #a
 #endif
 
+// NOTE(zaklaus): same as PKT_UINT on msgpack, a single bit in bitstream codecs
+#ifndef PKT_BOOL
+#define PKT_BOOL(t, a) PKT_UINT(t, a)
+#endif
+
 #ifndef PKT_REAL
 #define PKT_REAL(t, a) .type = CWP_ITEM_DOUBLE, .offset = PKT_OFFSETOF(t, a), .size = PKT_FIELD_SIZEOF(t,a), .it_size = PKT_FIELD_SIZEOF(t,a), .name = #a
 #endif
@@ -120,13 +139,34 @@ typedef struct pkt_desc {
     uint8_t skip_eq;
 } pkt_desc;
 
-int32_t pkt_unpack_struct(cw_unpack_context *uc, pkt_desc *desc, void *raw_blob, uint32_t blob_size);
-int32_t pkt_pack_struct(cw_pack_context *pc, pkt_desc *desc, void *raw_blob, uint32_t blob_size);
+int32_t pkt_unpack_struct(pkt_ctx *ctx, cw_unpack_context *uc, pkt_desc *desc, void *raw_blob, uint32_t blob_size);
+int32_t pkt_pack_struct(pkt_ctx *ctx, cw_pack_context *pc, pkt_desc *desc, void *raw_blob, uint32_t blob_size);
+
+// NOTE(zaklaus): RLE-compressed bin fields, shared by table-driven and generated codecs
+int32_t pkt_unpack_array(pkt_ctx *ctx, cw_unpack_context *uc, void *dst, uint32_t size);
+int32_t pkt_pack_array(pkt_ctx *ctx, cw_pack_context *pc, void const *src, uint32_t size);
+
+// NOTE(zaklaus): generated codecs, see pkt/packet_codec.h
+#ifndef PKT_CODEC_TABLE_DRIVEN
+#define PKT_CODEC_TABLE_DRIVEN 0
+#endif
+
+#define PKT_CODEC_DECLARE(name, type) \
+    extern pkt_desc name##_desc[]; \
+    int32_t name##_pack(pkt_ctx *ctx, cw_pack_context *pc, type const *pkt); \
+    int32_t name##_unpack(pkt_ctx *ctx, cw_unpack_context *uc, type *pkt); \
+    size_t name##_encode(pkt_ctx *ctx, type const *pkt); \
+    int32_t name##_decode(pkt_header *header, type *pkt)
+
+// NOTE(zaklaus): additional entry points for codecs built with PKT_CODEC_BITS, see pkt/packet_bits.h
+#define PKT_CODEC_DECLARE_BITS(name, type) \
+    int32_t name##_pack_bits(pkt_ctx *ctx, struct pkt_bits *bs, type const *pkt); \
+    int32_t name##_unpack_bits(pkt_ctx *ctx, struct pkt_bits *bs, type *pkt)
 
 static inline int32_t pkt_msg_decode(pkt_header *header, pkt_desc* desc, uint32_t args, void *raw_blob, uint32_t blob_size) {
     cw_unpack_context uc = {0};
     PKT_IF(pkt_unpack_msg(&uc, header, args));
-    PKT_IF(pkt_unpack_struct(&uc, desc, raw_blob, blob_size));
+    PKT_IF(pkt_unpack_struct(header->ctx, &uc, desc, raw_blob, blob_size));
     
     return pkt_validate_eof_msg(&uc);
 }
@@ -137,11 +177,11 @@ static inline uint32_t pkt_pack_desc_args(pkt_desc *desc) {
     return cnt;
 }
 
-static inline size_t pkt_table_encode(pkt_desc *desc, void *raw_blob, uint32_t blob_size) {
+static inline size_t pkt_table_encode(pkt_ctx *ctx, pkt_desc *desc, void *raw_blob, uint32_t blob_size) {
     assert(desc && raw_blob && blob_size > 0);
     cw_pack_context pc = {0};
-    pkt_pack_msg(&pc, pkt_pack_desc_args(desc));
-    pkt_pack_struct(&pc, desc, raw_blob, blob_size);
+    pkt_pack_msg(ctx, &pc, pkt_pack_desc_args(desc));
+    pkt_pack_struct(ctx, &pc, desc, raw_blob, blob_size);
     return pkt_pack_msg_size(&pc);
 }
 
@@ -117,20 +117,16 @@ void platform_get_block_realpos(float *x, float *y){
 }
 
 static game_keystate_data last_input_data = {0};
-static pkt_send_blockpos last_blockpos_data = {0};
+static float last_input_bx = 0.0f, last_input_by = 0.0f;
+static double last_input_time = 0.0;
 
 inline static
 void platform_input_update_input_frame(game_keystate_data data) {
-    float mx = 0, my = 0;
-    platform_get_block_realpos(&mx, &my);
-    
-    if (mx != last_blockpos_data.mx || my != last_blockpos_data.my){
-        last_blockpos_data.mx = mx;
-        last_blockpos_data.my = my;
-        game_action_send_blockpos(mx, my);
-    }
+    float bx = 0, by = 0;
+    platform_get_block_realpos(&bx, &by);
     
     // NOTE(zaklaus): Test if there are any changes
+    if (bx != last_input_bx || by != last_input_by) goto send_data;
     if (data.x != last_input_data.x) goto send_data;
     if (data.y != last_input_data.y) goto send_data;
     if (data.use != last_input_data.use) goto send_data;
@@ -147,11 +143,21 @@ void platform_input_update_input_frame(game_keystate_data data) {
     if (data.placement_num != last_input_data.placement_num) goto send_data;
     if (data.deletion_mode != last_input_data.deletion_mode) goto send_data;
     if (zpl_memcompare(data.placements, last_input_data.placements, zpl_size_of(data.placements))) goto send_data;
+    
+    // NOTE(zaklaus): input is unreliable, keep repeating it so the last change makes it through
+    // without pushing a new frame, otherwise one-shot actions like pick would fire again
+    if (get_cached_time() - last_input_time >= PKT_INPUT_RESEND_RATE) {
+        last_input_time = get_cached_time();
+        game_action_resend_keystate();
+    }
     return;
     
     send_data:
     last_input_data = data;
-    game_action_send_keystate(&data);
+    last_input_bx = bx;
+    last_input_by = by;
+    last_input_time = get_cached_time();
+    game_action_send_keystate(&data, bx, by);
 }
 
 
@@ -49,7 +49,7 @@ void OnDead(ecs_iter_t *it) {
 		Input *pi = ecs_get_mut_if(it->world, it->entities[i], Input);
 
 		if (ci) {
-			pkt_notification_send(0, 0, "Someone died!", zpl_bprintf("Player %d has died!", it->entities[i]));
+			pkt_notification_send(pkt_ctx_local(), 0, 0, "Someone died!", zpl_bprintf("Player %d has died!", it->entities[i]));
 			game_player_died(it->entities[i]);
 		}
 
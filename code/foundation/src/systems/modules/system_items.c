@@ -48,6 +48,7 @@ void PickItem(ecs_iter_t *it) {
                 } else if (range <= game_rules.item_attract_radius) {
                     v2->x = (p[i].x - p2->x) * game_rules.item_attract_force;
                     v2->y = (p[i].y - p2->y) * game_rules.item_attract_force;
+                    entity_wake(ent_id);
                 }
             }
             
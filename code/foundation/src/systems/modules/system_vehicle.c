@@ -1,6 +1,9 @@
 #include "dev/debug_draw.h"
 #include "models/entity.h"
 
+// NOTE(zaklaus): how far ahead of the car we probe for blocks to crash into
+#define VEH_LOOKAHEAD(x) (zpl_sign(x)*16.0f)
+
 void LeaveVehicle(ecs_iter_t *it) {
     Input *in = ecs_field(it, Input, 1);
     IsInVehicle *vehp = ecs_field(it, IsInVehicle, 2);
@@ -142,8 +145,8 @@ void VehicleHandling(ecs_iter_t *it) {
         v[i].y += ((fr_y + bk_y) / 2.0f - p[i].y);
         car->heading = zpl_arctan2(fr_y - bk_y, fr_x - bk_x);
         
-        float check_x = p[i].x+PHY_LOOKAHEAD(v[i].x);
-        float check_y = p[i].y+PHY_LOOKAHEAD(v[i].y);
+        float check_x = p[i].x+VEH_LOOKAHEAD(v[i].x);
+        float check_y = p[i].y+VEH_LOOKAHEAD(v[i].y);
         world_block_lookup lookahead = world_block_from_realpos(check_x, check_y);
         uint32_t flags = blocks_get_flags(lookahead.bid);
         if (flags & BLOCK_FLAG_COLLISION) {
@@ -0,0 +1,318 @@
+#include "physics.h"
+#include <stdlib.h>
+#include <math.h>
+
+#if PHYSICS_SIMD
+#include <emmintrin.h>
+#endif
+
+#define PHYSICS_LANES 4
+
+void physics_batch_clear(physics_batch *batch) {
+    batch->count = 0;
+}
+
+void physics_batch_free(physics_batch *batch) {
+#define X(field) free(batch->field);
+    X(a) X(b) X(dx) X(dy) X(ex) X(ey) X(r) X(depth) X(nx) X(ny)
+#undef X
+    *batch = (physics_batch){0};
+}
+
+static void physics_batch_grow(physics_batch *batch) {
+    uint32_t capacity = batch->capacity ? batch->capacity * 2 : 256;
+#define X(field) batch->field = realloc(batch->field, sizeof(*batch->field) * capacity);
+    X(a) X(b) X(dx) X(dy) X(ex) X(ey) X(r) X(depth) X(nx) X(ny)
+#undef X
+    batch->capacity = capacity;
+}
+
+void physics_batch_push(physics_batch *batch, uint32_t a, uint32_t b, float dx, float dy, float ex, float ey, float r) {
+    if (batch->count == batch->capacity) physics_batch_grow(batch);
+    uint32_t i = batch->count++;
+    batch->a[i] = a;
+    batch->b[i] = b;
+    batch->dx[i] = dx;
+    batch->dy[i] = dy;
+    batch->ex[i] = ex;
+    batch->ey[i] = ey;
+    batch->r[i] = r;
+}
+
+//~ NOTE(zaklaus): scalar lanes, used for the tail and on targets without SSE2
+
+static inline void physics_lane_aabb_aabb(physics_batch *batch, uint32_t i) {
+    float dx = batch->dx[i], dy = batch->dy[i];
+    float ox = batch->ex[i] - fabsf(dx);
+    float oy = batch->ey[i] - fabsf(dy);
+
+    batch->depth[i] = batch->nx[i] = batch->ny[i] = 0.0f;
+    if (ox < 0.0f || oy < 0.0f) return;
+
+    if (ox < oy) {
+        batch->depth[i] = ox;
+        batch->nx[i] = dx < 0.0f ? -1.0f : 1.0f;
+    } else {
+        batch->depth[i] = oy;
+        batch->ny[i] = dy < 0.0f ? -1.0f : 1.0f;
+    }
+}
+
+static inline void physics_lane_circle_circle(physics_batch *batch, uint32_t i) {
+    float dx = batch->dx[i], dy = batch->dy[i], r = batch->r[i];
+    float d2 = dx*dx + dy*dy;
+
+    batch->depth[i] = batch->nx[i] = batch->ny[i] = 0.0f;
+    if (d2 >= r*r) return;
+
+    float l = sqrtf(d2);
+    if (l != 0.0f) {
+        float inv = 1.0f / l;
+        batch->nx[i] = dx*inv;
+        batch->ny[i] = dy*inv;
+    } else {
+        batch->ny[i] = 1.0f;
+    }
+    batch->depth[i] = r - l;
+}
+
+static inline void physics_lane_circle_aabb(physics_batch *batch, uint32_t i) {
+    float dx = batch->dx[i], dy = batch->dy[i], r = batch->r[i];
+    float ex = batch->ex[i], ey = batch->ey[i];
+
+    // NOTE(zaklaus): closest point on the box, relative to the circle center
+    float lx = fmaxf(dx - ex, fminf(0.0f, dx + ex));
+    float ly = fmaxf(dy - ey, fminf(0.0f, dy + ey));
+    float d2 = lx*lx + ly*ly;
+
+    batch->depth[i] = batch->nx[i] = batch->ny[i] = 0.0f;
+    if (d2 >= r*r) return;
+
+    if (d2 != 0.0f) {
+        float d = sqrtf(d2);
+        float inv = 1.0f / d;
+        batch->depth[i] = r - d;
+        batch->nx[i] = lx*inv;
+        batch->ny[i] = ly*inv;
+        return;
+    }
+
+    // NOTE(zaklaus): center inside the box, push out along the shallower axis
+    float ox = ex - fabsf(dx);
+    float oy = ey - fabsf(dy);
+    if (ox < oy) {
+        batch->depth[i] = r + ox;
+        batch->nx[i] = dx > 0.0f ? 1.0f : -1.0f;
+    } else {
+        batch->depth[i] = r + oy;
+        batch->ny[i] = dy > 0.0f ? 1.0f : -1.0f;
+    }
+}
+
+//~ NOTE(zaklaus): kernels
+
+#if PHYSICS_SIMD
+static inline __m128 physics_abs4(__m128 v) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+static inline __m128 physics_select4(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// NOTE(zaklaus): -1 where the mask is set, +1 elsewhere
+static inline __m128 physics_sign4(__m128 neg_mask) {
+    return _mm_or_ps(_mm_and_ps(neg_mask, _mm_set1_ps(-0.0f)), _mm_set1_ps(1.0f));
+}
+#endif
+
+void physics_collide_aabb_aabb(physics_batch *batch) {
+    uint32_t i = 0;
+
+#if PHYSICS_SIMD
+    __m128 zero = _mm_setzero_ps();
+    for (; i + PHYSICS_LANES <= batch->count; i += PHYSICS_LANES) {
+        __m128 dx = _mm_loadu_ps(batch->dx + i);
+        __m128 dy = _mm_loadu_ps(batch->dy + i);
+        __m128 ox = _mm_sub_ps(_mm_loadu_ps(batch->ex + i), physics_abs4(dx));
+        __m128 oy = _mm_sub_ps(_mm_loadu_ps(batch->ey + i), physics_abs4(dy));
+
+        __m128 hit = _mm_and_ps(_mm_cmpge_ps(ox, zero), _mm_cmpge_ps(oy, zero));
+        __m128 x_axis = _mm_cmplt_ps(ox, oy);
+        __m128 hit_x = _mm_and_ps(hit, x_axis);
+        __m128 hit_y = _mm_andnot_ps(x_axis, hit);
+
+        _mm_storeu_ps(batch->depth + i, _mm_and_ps(hit, physics_select4(x_axis, ox, oy)));
+        _mm_storeu_ps(batch->nx + i, _mm_and_ps(hit_x, physics_sign4(_mm_cmplt_ps(dx, zero))));
+        _mm_storeu_ps(batch->ny + i, _mm_and_ps(hit_y, physics_sign4(_mm_cmplt_ps(dy, zero))));
+    }
+#endif
+
+    for (; i < batch->count; i++) {
+        physics_lane_aabb_aabb(batch, i);
+    }
+}
+
+void physics_collide_circle_circle(physics_batch *batch) {
+    uint32_t i = 0;
+
+#if PHYSICS_SIMD
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    for (; i + PHYSICS_LANES <= batch->count; i += PHYSICS_LANES) {
+        __m128 dx = _mm_loadu_ps(batch->dx + i);
+        __m128 dy = _mm_loadu_ps(batch->dy + i);
+        __m128 r = _mm_loadu_ps(batch->r + i);
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+        __m128 hit = _mm_cmplt_ps(d2, _mm_mul_ps(r, r));
+        __m128 l = _mm_sqrt_ps(d2);
+        __m128 apart = _mm_cmpneq_ps(l, zero);
+        __m128 inv = _mm_and_ps(apart, _mm_div_ps(one, l));
+
+        _mm_storeu_ps(batch->depth + i, _mm_and_ps(hit, _mm_sub_ps(r, l)));
+        _mm_storeu_ps(batch->nx + i, _mm_and_ps(hit, _mm_mul_ps(dx, inv)));
+        _mm_storeu_ps(batch->ny + i, _mm_and_ps(hit, physics_select4(apart, _mm_mul_ps(dy, inv), one)));
+    }
+#endif
+
+    for (; i < batch->count; i++) {
+        physics_lane_circle_circle(batch, i);
+    }
+}
+
+void physics_collide_circle_aabb(physics_batch *batch) {
+    uint32_t i = 0;
+
+#if PHYSICS_SIMD
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1.0f);
+    for (; i + PHYSICS_LANES <= batch->count; i += PHYSICS_LANES) {
+        __m128 dx = _mm_loadu_ps(batch->dx + i);
+        __m128 dy = _mm_loadu_ps(batch->dy + i);
+        __m128 ex = _mm_loadu_ps(batch->ex + i);
+        __m128 ey = _mm_loadu_ps(batch->ey + i);
+        __m128 r = _mm_loadu_ps(batch->r + i);
+
+        __m128 lx = _mm_max_ps(_mm_sub_ps(dx, ex), _mm_min_ps(zero, _mm_add_ps(dx, ex)));
+        __m128 ly = _mm_max_ps(_mm_sub_ps(dy, ey), _mm_min_ps(zero, _mm_add_ps(dy, ey)));
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly));
+        __m128 hit = _mm_cmplt_ps(d2, _mm_mul_ps(r, r));
+
+        // NOTE(zaklaus): shallow lanes, center outside of the box
+        __m128 d = _mm_sqrt_ps(d2);
+        __m128 shallow = _mm_cmpneq_ps(d2, zero);
+        __m128 inv = _mm_and_ps(shallow, _mm_div_ps(one, d));
+
+        // NOTE(zaklaus): deep lanes, center inside of the box
+        __m128 ox = _mm_sub_ps(ex, physics_abs4(dx));
+        __m128 oy = _mm_sub_ps(ey, physics_abs4(dy));
+        __m128 x_axis = _mm_cmplt_ps(ox, oy);
+        __m128 deep_depth = _mm_add_ps(r, physics_select4(x_axis, ox, oy));
+        __m128 deep_nx = _mm_and_ps(x_axis, physics_sign4(_mm_cmple_ps(dx, zero)));
+        __m128 deep_ny = _mm_andnot_ps(x_axis, physics_sign4(_mm_cmple_ps(dy, zero)));
+
+        _mm_storeu_ps(batch->depth + i, _mm_and_ps(hit, physics_select4(shallow, _mm_sub_ps(r, d), deep_depth)));
+        _mm_storeu_ps(batch->nx + i, _mm_and_ps(hit, physics_select4(shallow, _mm_mul_ps(lx, inv), deep_nx)));
+        _mm_storeu_ps(batch->ny + i, _mm_and_ps(hit, physics_select4(shallow, _mm_mul_ps(ly, inv), deep_ny)));
+    }
+#endif
+
+    for (; i < batch->count; i++) {
+        physics_lane_circle_aabb(batch, i);
+    }
+}
+
+//~ NOTE(zaklaus): swept tests
+
+bool physics_segment_aabb(float dx, float dy, float cx, float cy, float ex, float ey, float *toi) {
+    float t_min = 0.0f, t_max = 1.0f;
+    float d[2] = { dx, dy };
+    float c[2] = { cx, cy };
+    float e[2] = { ex, ey };
+
+    // NOTE(zaklaus): clip the segment against both slabs
+    for (int axis = 0; axis < 2; axis++) {
+        float lo = c[axis] - e[axis];
+        float hi = c[axis] + e[axis];
+
+        if (d[axis] == 0.0f) {
+            if (lo > 0.0f || hi < 0.0f) return false;
+            continue;
+        }
+
+        float inv = 1.0f / d[axis];
+        float t0 = lo * inv;
+        float t1 = hi * inv;
+        if (t0 > t1) { float t = t0; t0 = t1; t1 = t; }
+        t_min = fmaxf(t_min, t0);
+        t_max = fminf(t_max, t1);
+        if (t_min > t_max) return false;
+    }
+
+    *toi = t_min;
+    return true;
+}
+
+// NOTE(zaklaus): cells covered by the span lo..hi, touching a cell's border only counts on the side we move towards,
+// otherwise we'd either snag on walls we slide along or slip through a corner we hit dead on
+static inline void physics_grid_span(float lo, float hi, float dir, float cell_size, int32_t *c0, int32_t *c1) {
+    *c0 = dir < 0.0f ? (int32_t)ceilf(lo / cell_size) - 1 : (int32_t)floorf(lo / cell_size);
+    *c1 = dir > 0.0f ? (int32_t)floorf(hi / cell_size) : (int32_t)ceilf(hi / cell_size) - 1;
+    if (*c1 < *c0) *c1 = *c0;
+}
+
+bool physics_sweep_grid(float x, float y, float hx, float hy, float dx, float dy, float cell_size,
+                        physics_grid_solid_proc *solid, void *udata, physics_grid_hit *hit) {
+    float pos[2] = { x, y };
+    float ext[2] = { hx, hy };
+    float d[2] = { dx, dy };
+    float lead[2], boundary[2], t_next[2];
+    int32_t step[2];
+
+    for (int axis = 0; axis < 2; axis++) {
+        step[axis] = d[axis] > 0.0f ? 1 : -1;
+        lead[axis] = pos[axis] + ext[axis]*step[axis];
+
+        if (d[axis] == 0.0f) {
+            boundary[axis] = 0.0f;
+            t_next[axis] = INFINITY;
+            continue;
+        }
+
+        // NOTE(zaklaus): the first grid line ahead of the leading edge, an edge resting on a line crosses it right away
+        boundary[axis] = (d[axis] > 0.0f ? ceilf(lead[axis] / cell_size) : floorf(lead[axis] / cell_size)) * cell_size;
+        t_next[axis] = (boundary[axis] - lead[axis]) / d[axis];
+    }
+
+    for (;;) {
+        int axis = t_next[0] <= t_next[1] ? 0 : 1;
+        int other = axis ^ 1;
+        float t = t_next[axis];
+        if (t > 1.0f) break;
+
+        // NOTE(zaklaus): the row or column of cells the leading edge enters
+        int32_t c = (int32_t)floorf(boundary[axis] / cell_size + 0.5f) - (step[axis] < 0);
+        float o = pos[other] + d[other]*t;
+        int32_t o0, o1;
+        physics_grid_span(o - ext[other], o + ext[other], d[other], cell_size, &o0, &o1);
+
+        for (int32_t oc = o0; oc <= o1; oc++) {
+            int32_t cx = axis == 0 ? c : oc;
+            int32_t cy = axis == 0 ? oc : c;
+            if (!solid(cx, cy, udata)) continue;
+
+            hit->toi = t;
+            hit->nx = axis == 0 ? (float)-step[0] : 0.0f;
+            hit->ny = axis == 1 ? (float)-step[1] : 0.0f;
+            hit->cx = cx;
+            hit->cy = cy;
+            return true;
+        }
+
+        boundary[axis] += step[axis]*cell_size;
+        t_next[axis] = (boundary[axis] - lead[axis]) / d[axis];
+    }
+
+    return false;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// NOTE(zaklaus): batched narrow phase
+//
+// Candidate pairs are packed into a batch per shape combination, each lane holds the offset
+// from body a to body b and the shape sizes. The kernels process whole batches at once and
+// write a penetration depth and a normal pointing from a to b, a depth of 0 means no contact.
+// Results match tinyc2's manifolds for the same shapes.
+
+#ifndef PHYSICS_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PHYSICS_SIMD 1
+#else
+#define PHYSICS_SIMD 0
+#endif
+#endif
+
+typedef struct {
+    uint32_t count;
+    uint32_t capacity;
+
+    // NOTE(zaklaus): input
+    uint32_t *a, *b; // body indices, owned by the caller
+    float *dx, *dy;  // center of b minus center of a
+    float *ex, *ey;  // aabb half-extents, summed for aabb-aabb, of b for circle-aabb
+    float *r;        // circle radius, summed for circle-circle, of a for circle-aabb
+
+    // NOTE(zaklaus): output
+    float *depth;
+    float *nx, *ny;
+} physics_batch;
+
+void physics_batch_clear(physics_batch *batch);
+void physics_batch_free(physics_batch *batch);
+void physics_batch_push(physics_batch *batch, uint32_t a, uint32_t b, float dx, float dy, float ex, float ey, float r);
+
+void physics_collide_aabb_aabb(physics_batch *batch);
+void physics_collide_circle_circle(physics_batch *batch);
+
+// NOTE(zaklaus): a is the circle, b is the box, swap the pair and mirror the normal for the other way around
+void physics_collide_circle_aabb(physics_batch *batch);
+
+// NOTE(zaklaus): swept tests, the segment starts at the origin and moves by (dx, dy),
+// returns true and the time of impact within 0..1 if it enters the box, 0 if it starts inside
+bool physics_segment_aabb(float dx, float dy, float cx, float cy, float ex, float ey, float *toi);
+
+// NOTE(zaklaus): swept box against a grid of solid cells, the box centered at (x, y) with half-extents
+// (hx, hy) moves by (dx, dy). Only the cells its leading edges cross are visited, cells the box
+// overlaps at the start are ignored so that it can always move out of them.
+#define PHYSICS_GRID_SOLID_PROC(name) bool name(int32_t cx, int32_t cy, void *udata)
+typedef PHYSICS_GRID_SOLID_PROC(physics_grid_solid_proc);
+
+typedef struct {
+    float toi;         // 0..1
+    float nx, ny;      // surface normal of the cell, points towards the box
+    int32_t cx, cy;    // cell that was hit
+} physics_grid_hit;
+
+bool physics_sweep_grid(float x, float y, float hx, float hy, float dx, float dy, float cell_size,
+                        physics_grid_solid_proc *solid, void *udata, physics_grid_hit *hit);
@@ -1,7 +1,9 @@
 #include "zpl.h"
 #include "systems/systems.h"
+#include "systems/physics.h"
 #include "models/components.h"
 #include "world/world.h"
+#include "world/streamer.h"
 #include "world/blocks.h"
 #include "platform/profiler.h"
 #include "dev/debug_draw.h"
@@ -18,11 +20,55 @@ ZPL_DIAGNOSTIC_POP
 #define PHY_BLOCK_COLLISION 1
 #define PHY_C2_BLOCK_COLLISION 0
 #define PHY_WALK_DRAG 4.23f
-#define PHY_LOOKAHEAD(x) (zpl_sign(x)*16.0f)
+#define PHY_SLEEP_VELOCITY 0.5f
+#define PHY_SLEEP_TICKS 30
+#define PHY_BLOCK_HX (WORLD_BLOCK_SIZE/4.0f)
+#define PHY_BLOCK_HY 0.5f
+#define PHY_BLOCK_SKIN 0.01f
+#define PHY_BLOCK_SLIDES 3
 
 ecs_query_t *ecs_rigidbodies = 0;
+ecs_query_t *ecs_physbodies = 0;
 ecs_entity_t ecs_timer = 0;
 
+static uint32_t systems_threads = 1;
+
+void systems_setup_threads(uint32_t count) {
+	systems_threads = zpl_clamp(count, 1, SYSTEMS_MAX_THREADS);
+}
+
+// NOTE(zaklaus): multi-threaded systems only time the main thread's share of the work
+#define profile_mt(id, it) defer(\
+	(ecs_get_stage_id((it)->world) == 0 ? profiler_start(id) : (void)0),\
+	(ecs_get_stage_id((it)->world) == 0 ? profiler_stop(id) : (void)0))
+
+//~ NOTE(zaklaus): per-thread scratch
+//
+// Worker threads must not touch librg or other entities, so anything that would do so is
+// recorded here and applied on the main thread by FlushPhysicsUpdates.
+
+typedef struct {
+	ecs_entity_t ent;
+	librg_chunk chunk;
+	librg_chunk grid_chunk;
+} phys_chunk_update;
+
+typedef struct {
+	zpl_array(phys_chunk_update) chunk_updates;
+	zpl_array(ecs_entity_t) wakes;
+} phys_thread_scratch;
+
+static phys_thread_scratch phys_scratch[SYSTEMS_MAX_THREADS] = {0};
+
+static inline phys_thread_scratch *phys_scratch_get(ecs_iter_t *it) {
+	phys_thread_scratch *scratch = &phys_scratch[ecs_get_stage_id(it->world)];
+	if (!scratch->chunk_updates) {
+		zpl_array_init(scratch->chunk_updates, zpl_heap());
+		zpl_array_init(scratch->wakes, zpl_heap());
+	}
+	return scratch;
+}
+
 #include "modules/system_onfoot.c"
 #include "modules/system_health.c"
 #include "modules/system_demo.c"
@@ -32,15 +78,6 @@ ecs_entity_t ecs_timer = 0;
 #include "modules/system_producer.c"
 #include "modules/system_blueprint.c"
 
-static inline float physics_correction(float x, float vx, float bounce, float dim) {
-    float r = (((zpl_max(0.0f, dim - zpl_abs(x))*zpl_sign(x)))*dim);
-    return r + (-vx*bounce);
-}
-
-static inline bool physics_check_aabb(float a1x, float a2x, float a1y, float a2y, float b1x, float b2x, float b1y, float b2y) {
-    return (a1x < b2x && a2x > b1x && a1y < b2y && a2y > b1y);
-}
-
 static inline bool BlockCollisionIslandTest(Position *p, librg_chunk ch_p) {
 	// collect islands
 	collision_island islands[16];
@@ -59,212 +96,376 @@ static inline bool BlockCollisionIslandTest(Position *p, librg_chunk ch_p) {
 	return 0;
 }
 
+static PHYSICS_GRID_SOLID_PROC(phys_block_solid) {
+	(void)udata;
+	return world_block_is_solid(cx, cy);
+}
+
+static inline float phys_block_bounce(int32_t cx, int32_t cy) {
+	float x = (cx + 0.5f) * WORLD_BLOCK_SIZE;
+	float y = (cy + 0.5f) * WORLD_BLOCK_SIZE;
+	if (x < 0.0f || y < 0.0f || x >= world_dim() || y >= world_dim()) return 0.0f;
+	return blocks_get_bounce(world_block_from_realpos(x, y).bid);
+}
+
+// NOTE(zaklaus): moves the body by its velocity, stops at the first block on the way and slides
+// along it with what's left of the step, the velocity into the block is reflected by its bounce
+static inline void phys_block_move_and_slide(Position *p, Velocity *v, float dt) {
+	float rx = v->x*dt;
+	float ry = v->y*dt;
+
+	for (int k = 0; k < PHY_BLOCK_SLIDES && (rx != 0.0f || ry != 0.0f); k++) {
+		physics_grid_hit hit;
+		if (!physics_sweep_grid(p->x, p->y, PHY_BLOCK_HX, PHY_BLOCK_HY, rx, ry, WORLD_BLOCK_SIZE, phys_block_solid, NULL, &hit)) {
+			p->x += rx;
+			p->y += ry;
+			return;
+		}
+
+		// NOTE(zaklaus): move up to the contact, keep a tiny gap so we don't start the next step touching the block
+		p->x += rx*hit.toi + hit.nx*PHY_BLOCK_SKIN;
+		p->y += ry*hit.toi + hit.ny*PHY_BLOCK_SKIN;
+		rx *= 1.0f - hit.toi;
+		ry *= 1.0f - hit.toi;
+
+		float bounce = phys_block_bounce(hit.cx, hit.cy);
+		if (hit.nx != 0.0f) {
+			v->x = -v->x*bounce;
+			rx = -rx*bounce;
+		} else {
+			v->y = -v->y*bounce;
+			ry = -ry*bounce;
+		}
+
+#if 1
+		{
+			debug_v2 a = {p->x-PHY_BLOCK_HX, p->y-PHY_BLOCK_HY};
+			debug_v2 b = {p->x+PHY_BLOCK_HX, p->y+PHY_BLOCK_HY};
+			debug_push_rect(a, b, 0xFF0000FF);
+		}
+#endif
+	}
+}
+
+// NOTE(zaklaus): integrates solid bodies, IntegratePositions only takes care of triggers
 void BlockCollisions(ecs_iter_t *it) {
-	profile(PROF_PHYS_BLOCK_COLS) {
+	profile_mt(PROF_PHYS_BLOCK_COLS, it) {
 		Position *p = ecs_field(it, Position, 1);
 		Velocity *v = ecs_field(it, Velocity, 2);
+		const float dt = safe_dt(it);
         
 		for (int i = 0; i < it->count; i++) {
-			if (ecs_get(it->world, it->entities[i], IsInVehicle)) {
-				continue;
-			}
-
-			//if (zpl_abs(v[i].x) >= 0.0001f || zpl_abs(v[i].y) >= 0.0001f)
+			// NOTE(zaklaus): world bounds
 			{
-				// NOTE(zaklaus): world bounds
-				{
-					float w = (float)world_dim();
-					p[i].x = zpl_clamp(p[i].x, 0, w-1);
-					p[i].y = zpl_clamp(p[i].y, 0, w-1);
-				}
+				float w = (float)world_dim();
+				p[i].x = zpl_clamp(p[i].x, 0, w-1);
+				p[i].y = zpl_clamp(p[i].y, 0, w-1);
+			}
 
 #if PHY_C2_BLOCK_COLLISION==1
-				// collision islands
-				{
-					librg_chunk chunk_id = librg_chunk_from_realpos(world_tracker(), p[i].x, p[i].y, 0);
+			// collision islands
+			{
+				librg_chunk chunk_id = librg_chunk_from_realpos(world_tracker(), p[i].x, p[i].y, 0);
 
-					if (BlockCollisionIslandTest((p+i), chunk_id))
-						continue;
-				}
+				if (BlockCollisionIslandTest((p+i), chunk_id))
+					continue;
+			}
 #endif
-                
+
 #if PHY_BLOCK_COLLISION==1
-				// NOTE(zaklaus): X axis
-				{
-					world_block_lookup lookup = world_block_from_realpos(p[i].x+PHY_LOOKAHEAD(v[i].x), p[i].y);
-					uint32_t flags = blocks_get_flags(lookup.bid);
-					float bounce = blocks_get_bounce(lookup.bid);
-					if (flags & BLOCK_FLAG_COLLISION && physics_check_aabb(p[i].x-WORLD_BLOCK_SIZE/4, p[i].x+WORLD_BLOCK_SIZE/4, p[i].y-0.5f, p[i].y+0.5f, lookup.aox-WORLD_BLOCK_SIZE/2, lookup.aox+WORLD_BLOCK_SIZE/2, lookup.aoy-WORLD_BLOCK_SIZE/2, lookup.aoy+WORLD_BLOCK_SIZE/2)) {
-#if 1
-						{
-							debug_v2 a = {p[i].x-WORLD_BLOCK_SIZE/4 + PHY_LOOKAHEAD(v[i].x), p[i].y-0.5f};
-							debug_v2 b = {p[i].x+WORLD_BLOCK_SIZE/4 + PHY_LOOKAHEAD(v[i].x), p[i].y+0.5f};
-							debug_push_rect(a, b, 0xFF0000FF);
-						}
-#endif
-						v[i].x = physics_correction(lookup.ox, v[i].x, bounce, WORLD_BLOCK_SIZE/2);
-					}
-				}
-                
-				// NOTE(zaklaus): Y axis
-				{
-					world_block_lookup lookup = world_block_from_realpos(p[i].x, p[i].y+PHY_LOOKAHEAD(v[i].y));
-					uint32_t flags = blocks_get_flags(lookup.bid);
-					float bounce = blocks_get_bounce(lookup.bid);
-#if 0
-					{
-						debug_v2 a = {lookup.aox-WORLD_BLOCK_SIZE/2, lookup.aoy-WORLD_BLOCK_SIZE/2};
-						debug_v2 b = {lookup.aox+WORLD_BLOCK_SIZE/2, lookup.aoy+WORLD_BLOCK_SIZE/2};
-						debug_push_rect(a, b, 0xFFFFFFFF);
-					}
-#endif
-					if (flags & BLOCK_FLAG_COLLISION && physics_check_aabb(p[i].x-WORLD_BLOCK_SIZE/4, p[i].x+WORLD_BLOCK_SIZE/4, p[i].y-0.5f, p[i].y+0.5f, lookup.aox-WORLD_BLOCK_SIZE/2, lookup.aox+WORLD_BLOCK_SIZE/2, lookup.aoy-WORLD_BLOCK_SIZE/2, lookup.aoy+WORLD_BLOCK_SIZE/2)) {
-#if 1
-						{
-							debug_v2 a = {p[i].x-WORLD_BLOCK_SIZE/4, p[i].y-0.5f + PHY_LOOKAHEAD(v[i].y)};
-							debug_v2 b = {p[i].x+WORLD_BLOCK_SIZE/4, p[i].y+0.5f + PHY_LOOKAHEAD(v[i].y)};
-							debug_push_rect(a, b, 0xFF0000FF);
-						}
-#endif
-						v[i].y = physics_correction(lookup.oy, v[i].y, bounce, WORLD_BLOCK_SIZE/4);
-					}
-				}
+			phys_block_move_and_slide(&p[i], &v[i], dt);
+#else
+			p[i].x += v[i].x*dt;
+			p[i].y += v[i].y*dt;
 #endif
-			}
 		}
 	}
 }
 
-#define MAX_PHYSBODY_CHECKS 512
+//~ NOTE(zaklaus): body collisions
+//
+// Active bodies are packed into a SoA once per tick and sorted by their left edge along x,
+// sweep and prune then yields every overlapping pair exactly once. Pairs are sorted into
+// batches by shape and run through the kernels in physics.c, both bodies get their
+// response from a single narrow phase result.
+
+typedef struct {
+	float min_x;
+	float max_x;
+	uint32_t idx;
+} phys_sweep_key;
+
+static struct {
+	uint32_t count;
+	uint32_t capacity;
+
+	float *x, *y;
+	float *hx, *hy;   // half-extents of the box
+	float *reach;     // farthest distance at which another body is considered
+	float *mass;
+	float *dvx, *dvy; // accumulated response, applied after the sweep
+	uint8_t *kind;
+	uint8_t *asleep;
+	ecs_entity_t *ent;
+	Velocity **vel;
+	phys_sweep_key *keys;
+} phys_bodies = {0};
+
+static void phys_bodies_reserve(uint32_t count) {
+	if (count <= phys_bodies.capacity) return;
+	uint32_t capacity = zpl_max(count, phys_bodies.capacity*2);
+
+#define PHYS_BODIES_FIELDS\
+	X(x) X(y) X(hx) X(hy) X(reach) X(mass) X(dvx) X(dvy) X(kind) X(asleep) X(ent) X(vel) X(keys)
+
+#define X(field)\
+	zpl_mfree(phys_bodies.field);\
+	phys_bodies.field = zpl_malloc(sizeof(*phys_bodies.field) * capacity);
+	PHYS_BODIES_FIELDS
+#undef X
+
+	phys_bodies.capacity = capacity;
+}
 
-void BodyCollisions(ecs_iter_t *it) {
-	Position *p = ecs_field(it, Position, 1);
-	Velocity *v = ecs_field(it, Velocity, 2);
-	PhysicsBody *b = ecs_field(it, PhysicsBody, 3);
+static void phys_bodies_gather(ecs_world_t *ecs) {
+	uint32_t count = 0;
+	ecs_iter_t it = ecs_query_iter(ecs, ecs_physbodies);
+	while (ecs_query_next(&it)) {
+		count += it.count;
+	}
+
+	phys_bodies_reserve(count);
+	phys_bodies.count = 0;
+
+	it = ecs_query_iter(ecs, ecs_physbodies);
+	while (ecs_query_next(&it)) {
+		Position *p = ecs_field(&it, Position, 1);
+		Velocity *v = ecs_field(&it, Velocity, 2);
+		PhysicsBody *b = ecs_field(&it, PhysicsBody, 3);
+		bool asleep = ecs_field_is_set(&it, 6);
+
+		for (int i = 0; i < it.count; i++) {
+			uint32_t k = phys_bodies.count++;
+			float hx = WORLD_BLOCK_SIZE / 2;
+			float hy = WORLD_BLOCK_SIZE / 4;
+
+			phys_bodies.x[k] = p[i].x;
+			phys_bodies.y[k] = p[i].y;
+			phys_bodies.hx[k] = hx;
+			phys_bodies.hy[k] = hy;
+			phys_bodies.reach[k] = zpl_sqrt((hx*hx + hy*hy)*2.0f);
+			phys_bodies.mass[k] = b[i].mass;
+			phys_bodies.dvx[k] = 0.0f;
+			phys_bodies.dvy[k] = 0.0f;
+			phys_bodies.kind[k] = b[i].kind;
+			phys_bodies.asleep[k] = asleep;
+			phys_bodies.ent[k] = it.entities[i];
+			phys_bodies.vel[k] = &v[i];
+			phys_bodies.keys[k] = (phys_sweep_key){
+				.min_x = p[i].x - phys_bodies.reach[k],
+				.max_x = p[i].x + phys_bodies.reach[k],
+				.idx = k,
+			};
+		}
+	}
+}
+
+static ZPL_COMPARE_PROC(phys_sweep_key_cmp) {
+	float ax = ((phys_sweep_key const*)a)->min_x;
+	float bx = ((phys_sweep_key const*)b)->min_x;
+	return ax < bx ? -1 : ax > bx;
+}
+
+static inline float phys_mass_ratio(float self, float other) {
+	float m1 = other == INFINITE_MASS ? self : other;
+	float m2 = self == INFINITE_MASS ? (ZPL_F32_MAX-1.0f) : self;
+	return m1 / m2;
+}
+
+static inline float phys_bodies_radius(uint32_t k) {
+	return phys_bodies.reach[k]*phys_bodies.reach[k]/2.f;
+}
+
+// NOTE(zaklaus): the normal points from a to b, b receives the mirrored response
+static inline void phys_bodies_respond(uint32_t a, uint32_t b, float nx, float ny, float d) {
+	float ratio_a = phys_mass_ratio(phys_bodies.mass[a], phys_bodies.mass[b]);
+	float ratio_b = phys_mass_ratio(phys_bodies.mass[b], phys_bodies.mass[a]);
+
+	phys_bodies.dvx[a] -= nx*d*ratio_a;
+	phys_bodies.dvy[a] -= ny*d*ratio_a;
+	phys_bodies.dvx[b] += nx*d*ratio_b;
+	phys_bodies.dvy[b] += ny*d*ratio_b;
+}
+
+// NOTE(zaklaus): generic path for shapes the batched kernels do not cover
+static void phys_bodies_collide_c2(uint32_t a, uint32_t b) {
+	float p_x = phys_bodies.x[a];
+	float p_y = phys_bodies.y[a];
+	float p2_x = phys_bodies.x[b];
+	float p2_y = phys_bodies.y[b];
+
+	c2AABB box_a = {
+		.min = { p_x - phys_bodies.hx[a], p_y - phys_bodies.hy[a] },
+		.max = { p_x + phys_bodies.hx[a], p_y + phys_bodies.hy[a] },
+	};
+
+	c2AABB box_b = {
+		.min = { p2_x - phys_bodies.hx[b], p2_y - phys_bodies.hy[b] },
+		.max = { p2_x + phys_bodies.hx[b], p2_y + phys_bodies.hy[b] },
+	};
+
+	c2Circle circle_a = {
+		.p = { p_x, p_y },
+		.r = phys_bodies_radius(a),
+	};
+
+	c2Circle circle_b = {
+		.p = { p2_x, p2_y },
+		.r = phys_bodies_radius(b),
+	};
+
+	const void *shapes_a[] = { &circle_a, &box_a };
+	const void *shapes_b[] = { &circle_b, &box_b };
+
+	c2Manifold m = { 0 };
+	c2Collide(shapes_a[phys_bodies.kind[a]], 0, phys_bodies.kind[a], shapes_b[phys_bodies.kind[b]], 0, phys_bodies.kind[b], &m);
+
+	for (int k = 0; k < m.count; k++) {
+		phys_bodies_respond(a, b, m.n.x, m.n.y, m.depths[k]);
+	}
+}
+
+enum {
+	PHYS_PAIRS_AABB_AABB,
+	PHYS_PAIRS_CIRCLE_CIRCLE,
+	PHYS_PAIRS_CIRCLE_AABB,
+
+	PHYS_PAIRS_COUNT
+};
+
+static physics_batch phys_pairs[PHYS_PAIRS_COUNT] = {0};
+
+static void phys_bodies_pair(uint32_t a, uint32_t b) {
+	// NOTE(zaklaus): resting bodies stay at rest until something awake bumps into them
+	if (phys_bodies.asleep[a] && phys_bodies.asleep[b])
+		return;
+
+	float dx = phys_bodies.x[b] - phys_bodies.x[a];
+	float dy = phys_bodies.y[b] - phys_bodies.y[a];
+
+	// do a basic sweep first
+	{
+		float r1 = phys_bodies.reach[a]*phys_bodies.reach[a];
+		float r2 = phys_bodies.reach[b]*phys_bodies.reach[b];
+		float d = (dx*dx + dy*dy);
 
+		if (d > r1 && d > r2)
+			return;
+	}
+
+	uint8_t ka = phys_bodies.kind[a];
+	uint8_t kb = phys_bodies.kind[b];
+
+	if (ka == PHYS_AABB && kb == PHYS_AABB) {
+		physics_batch_push(&phys_pairs[PHYS_PAIRS_AABB_AABB], a, b, dx, dy,
+						   phys_bodies.hx[a] + phys_bodies.hx[b], phys_bodies.hy[a] + phys_bodies.hy[b], 0.0f);
+	} else if (ka == PHYS_CIRCLE && kb == PHYS_CIRCLE) {
+		physics_batch_push(&phys_pairs[PHYS_PAIRS_CIRCLE_CIRCLE], a, b, dx, dy, 0.0f, 0.0f,
+						   phys_bodies_radius(a) + phys_bodies_radius(b));
+	} else if (ka == PHYS_CIRCLE && kb == PHYS_AABB) {
+		physics_batch_push(&phys_pairs[PHYS_PAIRS_CIRCLE_AABB], a, b, dx, dy,
+						   phys_bodies.hx[b], phys_bodies.hy[b], phys_bodies_radius(a));
+	} else if (ka == PHYS_AABB && kb == PHYS_CIRCLE) {
+		physics_batch_push(&phys_pairs[PHYS_PAIRS_CIRCLE_AABB], b, a, -dx, -dy,
+						   phys_bodies.hx[a], phys_bodies.hy[a], phys_bodies_radius(b));
+	} else {
+		phys_bodies_collide_c2(a, b);
+	}
+}
+
+void BodyCollisions(ecs_iter_t *it) {
 	profile(PROF_PHYS_BODY_COLS) {
-		for (int i = 0; i < it->count; i++) {
-			if (ecs_get(it->world, it->entities[i], IsInVehicle)) {
-				continue;
+		phys_bodies_gather(it->world);
+
+		for (int i = 0; i < PHYS_PAIRS_COUNT; i++) {
+			physics_batch_clear(&phys_pairs[i]);
+		}
+
+		uint32_t count = phys_bodies.count;
+		phys_sweep_key *keys = phys_bodies.keys;
+		zpl_sort_array(keys, count, phys_sweep_key_cmp);
+
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t a = keys[i].idx;
+			float a_y = phys_bodies.y[a];
+			float a_reach = phys_bodies.reach[a];
+
+			for (uint32_t j = i + 1; j < count && keys[j].min_x <= keys[i].max_x; j++) {
+				uint32_t b = keys[j].idx;
+				if (zpl_abs(phys_bodies.y[b] - a_y) > a_reach + phys_bodies.reach[b]) continue;
+				phys_bodies_pair(a, b);
 			}
+		}
 
-#if 0
-			{
-				debug_v2 a = {p[i].x - WORLD_BLOCK_SIZE/2, p[i].y - WORLD_BLOCK_SIZE/2};
-				debug_v2 b = {p[i].x + WORLD_BLOCK_SIZE/2, p[i].y + WORLD_BLOCK_SIZE/2};
-				debug_push_rect(a, b, 0xFFFFFFFF);
+		physics_collide_aabb_aabb(&phys_pairs[PHYS_PAIRS_AABB_AABB]);
+		physics_collide_circle_circle(&phys_pairs[PHYS_PAIRS_CIRCLE_CIRCLE]);
+		physics_collide_circle_aabb(&phys_pairs[PHYS_PAIRS_CIRCLE_AABB]);
+
+		for (int k = 0; k < PHYS_PAIRS_COUNT; k++) {
+			physics_batch *batch = &phys_pairs[k];
+			for (uint32_t i = 0; i < batch->count; i++) {
+				if (batch->depth[i] == 0.0f) continue;
+				phys_bodies_respond(batch->a[i], batch->b[i], batch->nx[i], batch->ny[i], batch->depth[i]);
 			}
-#endif
+		}
 
-			size_t ents_count = MAX_PHYSBODY_CHECKS;
-			static int64_t ents[MAX_PHYSBODY_CHECKS] = {0};
-			librg_chunk chk = librg_entity_chunk_get(world_collision_grid(), it->entities[i]);
-			librg_world_fetch_chunk(world_collision_grid(), chk, ents, &ents_count);
-
-			for (size_t j = 0; j < ents_count; j++) {
-				uint64_t ent_id = (uint64_t)ents[j];
-				if (it->entities[i] == ent_id) continue;
-				if (!ecs_get(it->world, ent_id, PhysicsBody)) continue;
-				if ( ecs_get(it->world, ent_id, TriggerOnly)) continue;
-				if ( ecs_get(it->world, ent_id, IsInVehicle)) continue;
-
-				Position *p2 = ecs_get_mut(it->world, ent_id, Position);
-				Velocity *v2 = ecs_get_mut(it->world, ent_id, Velocity);
-				PhysicsBody *b2 = ecs_get_mut(it->world, ent_id, PhysicsBody);
-
-				float p_x = p[i].x;
-				float p_y = p[i].y;
-				float p2_x = p2->x /*+ v2->x*/;
-				float p2_y = p2->y /*+ v2->y*/;
-
-				c2AABB box_a = {
-					.min = { p_x - WORLD_BLOCK_SIZE / 2, p_y - WORLD_BLOCK_SIZE / 4 },
-					.max = { p_x + WORLD_BLOCK_SIZE / 2, p_y + WORLD_BLOCK_SIZE / 4 },
-				};
-
-				c2AABB box_b = {
-					.min = { p2_x - WORLD_BLOCK_SIZE / 2, p2_y - WORLD_BLOCK_SIZE / 4 },
-					.max = { p2_x + WORLD_BLOCK_SIZE / 2, p2_y + WORLD_BLOCK_SIZE / 4 },
-				};
-
-				// do a basic sweep first
-				float r1x = (box_a.max.x-box_a.min.x);
-				float r1y = (box_a.max.y-box_a.min.y);
-				float r1 = (r1x*r1x + r1y*r1y)*.5f;
-
-				float r2x = (box_b.max.x-box_b.min.x);
-				float r2y = (box_b.max.y-box_b.min.y);
-				float r2 = (r2x*r2x + r2y*r2y)*.5f;
-
-				{
-					float dx = (p2_x-p_x);
-					float dy = (p2_y-p_y);
-					float d = (dx*dx + dy*dy);
-
-					if (d > r1 && d > r2)
-						continue;
-				}
-
-				c2Circle circle_a = { 
-					.p = { p_x, p_y },
-					.r = r1/2.f,
-				};
-
-				c2Circle circle_b = {
-					.p = { p2_x, p2_y },
-					.r = r2/2.f,
-				};
-
-				const void *shapes_a[] = { &circle_a, &box_a };
-				const void *shapes_b[] = { &circle_b, &box_b };
-				
-				c2Manifold m = { 0 };
-				c2Collide(shapes_a[b[i].kind], 0, b[i].kind, shapes_b[b2->kind], 0, b2->kind, &m);
-
-				c2v n = m.n;
-
-				for (int k = 0; k < m.count; k++) {
-					float d = m.depths[k];
-#if 0
-					{
-						c2v pos = m.contact_points[k];
-						debug_v2 a = { pos.x, pos.y };
-						debug_v2 b = { pos.x + n.x*d, pos.y + n.y*d };
-						debug_push_line(a, b, 0xF77FFFFF);
-					}
-#endif
-					
-					float m1 = b2->mass == INFINITE_MASS ? b[i].mass : b2->mass;
-					float m2 = b[i].mass == INFINITE_MASS ? (ZPL_F32_MAX-1.0f) : b[i].mass;
-					float mass_ratio = m1 / m2;
-
-					v[i].x -= n.x*d*mass_ratio;
-					v[i].y -= n.y*d*mass_ratio;
-				}
+		for (uint32_t i = 0; i < count; i++) {
+			if (phys_bodies.dvx[i] == 0.0f && phys_bodies.dvy[i] == 0.0f) continue;
+			phys_bodies.vel[i]->x += phys_bodies.dvx[i];
+			phys_bodies.vel[i]->y += phys_bodies.dvy[i];
+
+			// NOTE(zaklaus): contacts wake sleepers up, they carry the wake further through their neighbours next tick
+			if (phys_bodies.asleep[i]) {
+				entity_wake(phys_bodies.ent[i]);
 			}
 		}
 	}
 }
 
+//~ NOTE(zaklaus): swept queries
+
+bool systems_sweep_blocks(float x0, float y0, float x1, float y1, float *toi) {
+	physics_grid_hit hit;
+	if (!physics_sweep_grid(x0, y0, 0.0f, 0.0f, x1 - x0, y1 - y0, WORLD_BLOCK_SIZE, phys_block_solid, NULL, &hit))
+		return false;
+
+	*toi = hit.toi;
+	return true;
+}
+
 void IntegratePositions(ecs_iter_t *it) {
-    profile(PROF_INTEGRATE_POS) {
+    profile_mt(PROF_INTEGRATE_POS, it) {
         Position *p = ecs_field(it, Position, 1);
         Velocity *v = ecs_field(it, Velocity, 2);
         StreamInfo *s = ecs_field(it, StreamInfo, 3);
+        bool is_trigger = ecs_field_is_set(it, 6);
+        phys_thread_scratch *scratch = phys_scratch_get(it);
         
         for (int i = 0; i < it->count; i++) {
-            if (ecs_get(it->world, it->entities[i], IsInVehicle)) {
-                continue;
-            }
-
             const float safe_dt_val = safe_dt(it);
 
-			// entity_set_position(it->entities[i], p[i].x+v[i].x*safe_dt(it), p[i].y+v[i].y*safe_dt(it));
-			p[i].x += v[i].x*safe_dt_val;
-			p[i].y += v[i].y*safe_dt_val;
+			// NOTE(zaklaus): solid bodies were already moved by BlockCollisions
+			if (is_trigger) {
+				p[i].x += v[i].x*safe_dt_val;
+				p[i].y += v[i].y*safe_dt_val;
+			}
 
-			librg_entity_chunk_set(world_tracker(), it->entities[i], librg_chunk_from_realpos(world_tracker(), p[i].x, p[i].y, 0));
-			librg_entity_chunk_set(world_collision_grid(), it->entities[i], librg_chunk_from_realpos(world_collision_grid(), p[i].x, p[i].y, 0));
+			phys_chunk_update update = {
+				.ent = it->entities[i],
+				.chunk = librg_chunk_from_realpos(world_tracker(), p[i].x, p[i].y, 0),
+				.grid_chunk = librg_chunk_from_realpos(world_collision_grid(), p[i].x, p[i].y, 0),
+			};
+			zpl_array_append(scratch->chunk_updates, update);
 
 			s[i].tick_delay = 0.0f;
     		s[i].last_update = 0.0f;
@@ -299,12 +500,10 @@ void ResetActivators(ecs_iter_t *it) {
 void ApplyWorldDragOnVelocity(ecs_iter_t *it) {
     Position *p = ecs_field(it, Position, 1);
     Velocity *v = ecs_field(it, Velocity, 2);
+    phys_thread_scratch *scratch = phys_scratch_get(it);
     
     for (int i = 0; i < it->count; i++) {
         if (zpl_abs(v[i].x) < 0.001f && zpl_abs(v[i].y) < 0.001f) continue;
-        if (ecs_get(it->world, it->entities[i], IsInVehicle)) {
-            continue;
-        }
         world_block_lookup lookup = world_block_from_realpos(p[i].x, p[i].y);
         float drag = zpl_clamp(blocks_get_drag(lookup.bid), 0.0f, 1.0f);
         float friction = blocks_get_friction(lookup.bid);
@@ -315,8 +514,46 @@ void ApplyWorldDragOnVelocity(ecs_iter_t *it) {
         
         if (   zpl_abs(v[i].x) > ENTITY_ACTION_VELOCITY_THRESHOLD
             || zpl_abs(v[i].y) > ENTITY_ACTION_VELOCITY_THRESHOLD) {
-            entity_wake(it->entities[i]);
+            zpl_array_append(scratch->wakes, it->entities[i]);
+        }
+    }
+}
+
+void PutBodiesToSleep(ecs_iter_t *it) {
+    Velocity *v = ecs_field(it, Velocity, 1);
+    SleepTimer *st = ecs_field(it, SleepTimer, 2);
+    
+    for (int i = 0; i < it->count; i++) {
+        if (zpl_abs(v[i].x) > PHY_SLEEP_VELOCITY || zpl_abs(v[i].y) > PHY_SLEEP_VELOCITY) {
+            st[i].still_ticks = 0;
+            continue;
+        }
+        
+        if (++st[i].still_ticks < PHY_SLEEP_TICKS) continue;
+        v[i].x = v[i].y = 0.0f;
+        ecs_add(it->world, it->entities[i], Sleeping);
+    }
+}
+
+void FlushPhysicsUpdates(ecs_iter_t *it) {
+    (void)it;
+    
+    for (uint32_t t = 0; t < systems_threads; t++) {
+        phys_thread_scratch *scratch = &phys_scratch[t];
+        if (!scratch->chunk_updates) continue;
+        
+        for (zpl_isize i = 0; i < zpl_array_count(scratch->chunk_updates); i++) {
+            phys_chunk_update *update = &scratch->chunk_updates[i];
+            streamer_entity_chunk_set(update->ent, update->chunk);
+            librg_entity_chunk_set(world_collision_grid(), update->ent, update->grid_chunk);
         }
+        
+        for (zpl_isize i = 0; i < zpl_array_count(scratch->wakes); i++) {
+            entity_wake(scratch->wakes[i]);
+        }
+        
+        zpl_array_clear(scratch->chunk_updates);
+        zpl_array_clear(scratch->wakes);
     }
 }
 
@@ -367,6 +604,7 @@ void SystemsImport(ecs_world_t *ecs) {
     ecs_timer = ecs_set_interval(ecs, 0, ECO2D_TICK_RATE);
 
 	ecs_rigidbodies = ecs_query_new(ecs, "components.Position, components.Velocity, components.PhysicsBody");
+	ecs_physbodies = ecs_query_new(ecs, "components.Position, components.Velocity, components.PhysicsBody, !components.TriggerOnly, !components.IsInVehicle, ?components.Sleeping");
 
 	ECS_SYSTEM(ecs, EnableWorldEdit, EcsOnLoad);
     
@@ -378,11 +616,13 @@ void SystemsImport(ecs_world_t *ecs) {
 	ECS_OBSERVER(ecs, OnDead, EcsOnAdd, components.Dead);
     
 	// collisions and movement physics
-	ECS_SYSTEM(ecs, ApplyWorldDragOnVelocity, EcsOnUpdate, components.Position, components.Velocity, !components.InAir, !components.TriggerOnly);
+	ECS_SYSTEM_MT(ecs, ApplyWorldDragOnVelocity, EcsOnUpdate, components.Position, components.Velocity, !components.InAir, !components.TriggerOnly, !components.IsInVehicle, !components.Sleeping);
 	ECS_SYSTEM(ecs, VehicleHandling, EcsOnUpdate, components.Vehicle, components.Position, components.Velocity);
-	ECS_SYSTEM(ecs, BodyCollisions, EcsOnUpdate, components.Position, components.Velocity, components.PhysicsBody, !components.TriggerOnly);
-	ECS_SYSTEM(ecs, BlockCollisions, EcsOnValidate, components.Position, components.Velocity, !components.TriggerOnly);
-	ECS_SYSTEM(ecs, IntegratePositions, EcsOnValidate, components.Position, components.Velocity, components.StreamInfo);
+	ECS_SYSTEM(ecs, BodyCollisions, EcsOnUpdate);
+	ECS_SYSTEM_MT(ecs, BlockCollisions, EcsOnValidate, components.Position, components.Velocity, !components.TriggerOnly, !components.IsInVehicle, !components.Sleeping);
+	ECS_SYSTEM_MT(ecs, IntegratePositions, EcsOnValidate, components.Position, components.Velocity, components.StreamInfo, !components.IsInVehicle, !components.Sleeping, ?components.TriggerOnly);
+	ECS_SYSTEM_MT(ecs, PutBodiesToSleep, EcsOnValidate, components.Velocity, components.SleepTimer, !components.Sleeping, !components.Input, !components.Vehicle, !components.Creature, !components.IsInVehicle);
+	ECS_SYSTEM(ecs, FlushPhysicsUpdates, EcsOnValidate);
     
 	// vehicles
     ECS_SYSTEM(ecs, EnterVehicle, EcsPostUpdate, components.Input, components.Position, !components.IsInVehicle);
@@ -420,4 +660,8 @@ void SystemsImport(ecs_world_t *ecs) {
 	
     ECS_SYSTEM(ecs, DisableWorldEdit, EcsPostUpdate);
     
+	if (systems_threads > 1) {
+		ecs_set_threads(ecs, systems_threads);
+		zpl_printf("[INFO] Running systems on %d threads\n", systems_threads);
+	}
 }
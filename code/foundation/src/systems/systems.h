@@ -21,5 +21,19 @@ extern ecs_entity_t ecs_timer;
 	ecs_entity_t timer_##id = ecs_set_interval(ecs, 0, ECO2D_TICK_RATE*time);\
 	ecs_set_tick_source(world, id, timer_##id);
 
+// NOTE(zaklaus): runs on every flecs worker, each one gets its own slice of the matched entities
+#define ECS_SYSTEM_MT(world, id, stage, ...)\
+	ECS_SYSTEM(world, id, stage, __VA_ARGS__);\
+	ecs_system(world, { .entity = id, .multi_threaded = true });
+
+#define SYSTEMS_MAX_THREADS 64
+
+// NOTE(zaklaus): amount of flecs worker threads, call before the world is created
+void systems_setup_threads(uint32_t count);
+
+// NOTE(zaklaus): continuous collision query, a point travels from (x0, y0) to (x1, y1),
+// toi receives the time of impact within 0..1 of the first colliding block
+bool systems_sweep_blocks(float x0, float y0, float x1, float y1, float *toi);
+
 
 void SystemsImport(ecs_world_t *ecs);
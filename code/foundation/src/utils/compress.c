@@ -1,34 +1,66 @@
 #include "compress.h"
+#include <string.h>
 
-uint32_t compress_rle(void* data, uint32_t size, uint8_t *dest) {
-    if (size < 1) return 0;
-    uint32_t total_size = 0;
-    uint8_t *buf = (uint8_t*)data;
-    uint8_t byte = buf[0];
-    uint16_t occurences = 1;
-    for (uint32_t i = 1; i <= size; i += 1){
-        if (buf[i] != byte || i == size) {
-            *(uint16_t*)dest = occurences; dest += 2;
-            *dest++ = byte;
-            byte = buf[i];
-            occurences = 1;
-            total_size += 3;
+static inline uint32_t compress__run_length(uint8_t const *buf, uint32_t size, uint8_t byte) {
+    if (size > COMPRESS_RLE_MAX_RUN) size = COMPRESS_RLE_MAX_RUN;
+    uint32_t i = 1;
+
+    // NOTE(zaklaus): most runs are short, look at a few bytes first before going word-wide
+    while (i < size && i < sizeof(uint64_t) && buf[i] == byte) i++;
+    if (i < sizeof(uint64_t)) return i;
+
+    // NOTE(zaklaus): compare 8 bytes at a time against the splatted byte, then finish the tail byte-wise
+    uint64_t splat = (uint64_t)byte * 0x0101010101010101ULL;
+    while (i + sizeof(uint64_t) <= size) {
+        uint64_t word;
+        memcpy(&word, buf + i, sizeof(word));
+        if (word != splat) break;
+        i += sizeof(uint64_t);
+    }
+    while (i < size && buf[i] == byte) i++;
+    return i;
+}
+
+int32_t compress_rle(void const *data, uint32_t size, uint8_t *dest, uint32_t dest_size) {
+    uint8_t const *buf = (uint8_t const*)data;
+    uint8_t *out = dest;
+    uint8_t *out_end = dest + (dest_size / 3) * 3;
+    uint32_t i = 0;
+    while (i < size) {
+        uint8_t byte = buf[i];
+        uint32_t run = 1;
+        if (i + 1 < size && buf[i + 1] == byte) {
+            run = compress__run_length(buf + i, size - i, byte);
         }
-        else occurences++;
+        if (out == out_end) return -1;
+        out[0] = (uint8_t)(run & 0xFF);
+        out[1] = (uint8_t)(run >> 8);
+        out[2] = byte;
+        out += 3;
+        i += run;
     }
-    return total_size;
+    return (int32_t)(out - dest);
 }
 
-uint32_t decompress_rle(void* data, uint32_t size, uint8_t *dest) {
-    if (size < 1) return 0;
+int32_t decompress_rle(void const *data, uint32_t size, uint8_t *dest, uint32_t dest_size) {
+    if (size % 3 != 0) return -1;
+    uint8_t const *buf = (uint8_t const*)data;
     uint32_t total_size = 0;
-    uint8_t *buf = (uint8_t*)data;
     for (uint32_t i = 0; i < size; i += 3){
-        uint16_t len = *(uint16_t*)&buf[i];
-        for (uint16_t j = 0; j < len; j += 1){
-            *dest++ = buf[i+2];
-            total_size++;
+        uint32_t len = (uint32_t)buf[i] | ((uint32_t)buf[i+1] << 8);
+        uint32_t room = dest_size - total_size;
+        if (room < len) return -1;
+
+        // NOTE(zaklaus): short runs get a single splatted word store if there's room for it
+        if (len == 1) {
+            dest[total_size] = buf[i+2];
+        } else if (len <= sizeof(uint64_t) && room >= sizeof(uint64_t)) {
+            uint64_t splat = (uint64_t)buf[i+2] * 0x0101010101010101ULL;
+            memcpy(dest + total_size, &splat, sizeof(splat));
+        } else {
+            memset(dest + total_size, buf[i+2], len);
         }
+        total_size += len;
     }
-    return total_size;
+    return (int32_t)total_size;
 }
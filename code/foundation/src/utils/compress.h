@@ -1,5 +1,13 @@
 #pragma once
 #include "cwpack/cwpack.h"
 
-uint32_t compress_rle(void* data, uint32_t size, uint8_t *dest);
-uint32_t decompress_rle(void* data, uint32_t size, uint8_t *dest);
+// NOTE(zaklaus): RLE stream is a list of [uint16 run length (LE), uint8 byte] triplets,
+// runs longer than COMPRESS_RLE_MAX_RUN are split into several triplets
+#define COMPRESS_RLE_MAX_RUN 0xFFFF
+
+// NOTE(zaklaus): worst case is one triplet per input byte
+#define COMPRESS_RLE_BOUND(size) ((size) * 3)
+
+// returns the amount of bytes written, or -1 if dest_size is too small (or the input is malformed)
+int32_t compress_rle(void const *data, uint32_t size, uint8_t *dest, uint32_t dest_size);
+int32_t decompress_rle(void const *data, uint32_t size, uint8_t *dest, uint32_t dest_size);
@@ -10,80 +10,110 @@ const char *class_names[] = {
 
 ZPL_TABLE_DEFINE(entity_view_tbl, entity_view_tbl_, entity_view);
 
-pkt_desc pkt_entity_view_desc[] = {
-    
-    { PKT_UINT(entity_view, kind) },
-    { PKT_UINT(entity_view, flag) },
-    { PKT_HALF(entity_view, x) },
-	{ PKT_HALF(entity_view, y) },
-	{ PKT_HALF(entity_view, hx) },
-	{ PKT_HALF(entity_view, hy) },
-    { PKT_HALF(entity_view, angle) },
-    
-    { PKT_KEEP_IF(entity_view, blocks_used, 0, 2) }, // NOTE(zaklaus): skip velocity for chunks
-    { PKT_HALF(entity_view, vx) },
-    { PKT_HALF(entity_view, vy) },
-    
-    { PKT_SKIP_IF(entity_view, blocks_used, 0, 3) }, // NOTE(zaklaus): skip blocks for anything else
-    { PKT_UINT(entity_view, chk_id) },
-    { PKT_ARRAY(entity_view, blocks) },
-    { PKT_ARRAY(entity_view, outer_blocks) },
-    
-    { PKT_KEEP_IF(entity_view, blocks_used, 0, 2) }, // NOTE(zaklaus): skip hp for chunks
-    { PKT_HALF(entity_view, hp) },
-    { PKT_HALF(entity_view, max_hp) },
-    
-    { PKT_KEEP_IF(entity_view, kind, EKIND_VEHICLE, 1) }, // NOTE(zaklaus): keep for vehicles
-    { PKT_HALF(entity_view, heading) },
-    { PKT_UINT(entity_view, inside_vehicle) },
-    { PKT_UINT(entity_view, veh_kind) },
-    
-    { PKT_KEEP_IF(entity_view, kind, EKIND_ITEM, 2) },
-    { PKT_UINT(entity_view, asset) },
-    { PKT_UINT(entity_view, quantity) },
-    { PKT_HALF(entity_view, durability) },
-    
-    { PKT_KEEP_IF(entity_view, kind, EKIND_DEVICE, 3) },
-    { PKT_UINT(entity_view, asset) },
-    { PKT_UINT(entity_view, progress_active) },
-    { PKT_UINT(entity_view, is_producer) },
-
-    { PKT_HALF(entity_view, progress_value) },
-
-	{ PKT_UINT(entity_view, spritesheet) },
-	{ PKT_UINT(entity_view, frame) },
-
-    { PKT_KEEP_IF(entity_view, has_items, true, 3) },
-    { PKT_UINT(entity_view, has_items) },
-    { PKT_UINT(entity_view, selected_item) },
-    { PKT_ARRAY(entity_view, items) },
-    
-    { PKT_UINT(entity_view, pick_ent) },
-    { PKT_UINT(entity_view, sel_ent) },
-    
-    { PKT_KEEP_IF(entity_view, has_storage_items, true, 4) },
-    { PKT_UINT(entity_view, has_storage_items) },
-    { PKT_UINT(entity_view, storage_selected_item) },
-    { PKT_ARRAY(entity_view, storage_items) },
-    { PKT_ARRAY(entity_view, craftables) },
-    
-    { PKT_END },
-};
-
-size_t entity_view_pack_struct(void *data, size_t len, entity_view *view) {
+// NOTE(zaklaus): entity views are streamed as a bitstream, set to 0 to get msgpack back for debugging
+#ifndef ENTITY_VIEW_BITSTREAM
+#define ENTITY_VIEW_BITSTREAM 1
+#endif
+
+#define PKT_CODEC_NAME pkt_entity_view
+#define PKT_CODEC_BITS 1
+#define PKT_CODEC_TYPE entity_view
+#define PKT_CODEC_FIELDS(F, KEEP_IF, SKIP_IF, END_IF) \
+    F(UINT, kind) \
+    F(UINT, flag) \
+    F(HALF, x) \
+    F(HALF, y) \
+    F(HALF, hx) \
+    F(HALF, hy) \
+    F(HALF, angle) \
+    \
+    /* NOTE(zaklaus): skip velocity for chunks */ \
+    KEEP_IF(blocks_used, 0, 2) \
+        F(HALF, vx) \
+        F(HALF, vy) \
+    END_IF \
+    \
+    /* NOTE(zaklaus): skip blocks for anything else */ \
+    SKIP_IF(blocks_used, 0, 3) \
+        F(UINT, chk_id) \
+        F(ARRAY, blocks) \
+        F(ARRAY, outer_blocks) \
+    END_IF \
+    \
+    /* NOTE(zaklaus): skip hp for chunks */ \
+    KEEP_IF(blocks_used, 0, 2) \
+        F(HALF, hp) \
+        F(HALF, max_hp) \
+    END_IF \
+    \
+    /* NOTE(zaklaus): keep for vehicles */ \
+    KEEP_IF(kind, EKIND_VEHICLE, 1) \
+        F(HALF, heading) \
+    END_IF \
+    F(BOOL, inside_vehicle) \
+    F(UINT, veh_kind) \
+    \
+    KEEP_IF(kind, EKIND_ITEM, 2) \
+        F(UINT, asset) \
+        F(UINT, quantity) \
+    END_IF \
+    F(HALF, durability) \
+    \
+    KEEP_IF(kind, EKIND_DEVICE, 3) \
+        F(UINT, asset) \
+        F(BOOL, progress_active) \
+        F(BOOL, is_producer) \
+    END_IF \
+    \
+    F(HALF, progress_value) \
+    \
+    F(UINT, spritesheet) \
+    F(UINT, frame) \
+    \
+    KEEP_IF(has_items, true, 3) \
+        F(BOOL, has_items) \
+        F(UINT, selected_item) \
+        F(ARRAY, items) \
+    END_IF \
+    \
+    F(UINT, pick_ent) \
+    F(UINT, sel_ent) \
+    \
+    KEEP_IF(has_storage_items, true, 4) \
+        F(BOOL, has_storage_items) \
+        F(UINT, storage_selected_item) \
+        F(ARRAY, storage_items) \
+        F(ARRAY, craftables) \
+    END_IF
+#include "pkt/packet_codec.h"
+
+size_t entity_view_pack_struct(pkt_ctx *ctx, void *data, size_t len, entity_view *view) {
+#if ENTITY_VIEW_BITSTREAM
+    pkt_bits bs = {0};
+    pkt_bits_init(&bs, data, (uint32_t)len);
+    if (pkt_entity_view_pack_bits(ctx, &bs, view) < 0) return 0;
+    pkt_bits_flush(&bs);
+    if (bs.error) return 0;
+    return bs.pos;
+#else
     cw_pack_context pc = {0};
     cw_pack_context_init(&pc, data, (unsigned long)len, 0);
-    pkt_pack_struct(&pc, pkt_entity_view_desc, PKT_STRUCT_PTR(view));
+    if (pkt_entity_view_pack(ctx, &pc, view) < 0 || pc.return_code != CWP_RC_OK) return 0;
     return pc.current - pc.start;
+#endif
 }
 
-entity_view entity_view_unpack_struct(void *data, size_t len) {
+entity_view entity_view_unpack_struct(pkt_ctx *ctx, void *data, size_t len) {
+    entity_view view = {0};
+#if ENTITY_VIEW_BITSTREAM
+    pkt_bits bs = {0};
+    pkt_bits_init(&bs, data, (uint32_t)len);
+    pkt_entity_view_unpack_bits(ctx, &bs, &view);
+#else
     cw_unpack_context uc = {0};
     cw_unpack_context_init(&uc, data, (unsigned long)len, 0);
-    
-    entity_view view = {0};
-    pkt_unpack_struct(&uc, pkt_entity_view_desc, PKT_STRUCT_PTR(&view));
-    
+    pkt_entity_view_unpack(ctx, &uc, &view);
+#endif
     return view;
 }
 
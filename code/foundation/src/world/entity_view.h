@@ -2,6 +2,7 @@
 #include "platform/system.h"
 #include "models/assets.h"
 #include "models/items.h"
+#include "pkt/packet.h"
 
 #define ZPL_PICO
 #include "zpl.h"
@@ -122,6 +123,7 @@ typedef struct entity_view {
     float tran_time;
 } entity_view;
 
+// NOTE(zaklaus): keyed by connection-scoped entity handles on remote clients, real entity ids otherwise
 ZPL_TABLE_DECLARE(, entity_view_tbl, entity_view_tbl_, entity_view);
 
 void entity_view_init(entity_view_tbl *map);
@@ -133,8 +135,9 @@ void entity_view_destroy(entity_view_tbl *map, uint64_t ent_id);
 entity_view *entity_view_get(entity_view_tbl *map, uint64_t ent_id);
 void entity_view_map(entity_view_tbl *map, void (*map_proc)(uint64_t key, entity_view *value));
 
-size_t entity_view_pack_struct(void *data, size_t len, entity_view *view);
-entity_view entity_view_unpack_struct(void *data, size_t len);
+// NOTE(zaklaus): returns 0 if the view does not fit into len
+size_t entity_view_pack_struct(pkt_ctx *ctx, void *data, size_t len, entity_view *view);
+entity_view entity_view_unpack_struct(pkt_ctx *ctx, void *data, size_t len);
 
 void entity_view_mark_for_removal(entity_view_tbl *map, uint64_t ent_id);
 void entity_view_mark_for_fadein(entity_view_tbl *map, uint64_t ent_id);
@@ -80,8 +80,11 @@ void lerp_entity_positions(uint64_t key, entity_view *data) {
             data->heading = smooth_val_spherical(data->heading, data->theading, view->delta_time[data->layer_id]);
         } else {
             (void)view;
-            data->x = data->tx;
-            data->y = data->ty;
+            // NOTE(zaklaus): local views hold the last simulated step, blend back towards the one before it
+            // so that movement stays smooth when we render faster than we simulate
+            float back = world_sim_step_size() * (1.0f - world_sim_alpha());
+            data->x = data->tx - data->vx*back;
+            data->y = data->ty - data->vy*back;
             data->heading = data->theading;
         }
     }
@@ -0,0 +1,104 @@
+#include "zpl.h"
+#include "world/region.h"
+
+#define REGION_REPORT_RATE 5.0
+
+static struct {
+    uint16_t cols, rows;
+    uint16_t chunk_amount;
+    uint16_t *chunk_regions; // NOTE(zaklaus): chunk -> region
+    uint8_t *chunk_border;   // NOTE(zaklaus): chunk lies within the ghost band of another region
+
+    // NOTE(zaklaus): stats
+    uint64_t crossings;
+    uint64_t ghost_entries;
+    double next_report;
+} region = { .cols = 1, .rows = 1 };
+
+void region_setup(uint16_t cols, uint16_t rows) {
+    region.cols = zpl_max(cols, 1);
+    region.rows = zpl_max(rows, 1);
+}
+
+static inline uint16_t region__from_chunkpos(int32_t x, int32_t y) {
+    int32_t cx = x * region.cols / region.chunk_amount;
+    int32_t cy = y * region.rows / region.chunk_amount;
+    return (uint16_t)(cy * region.cols + cx);
+}
+
+void region_init(librg_world *tracker, uint16_t chunk_amount) {
+    region.cols = zpl_min(region.cols, chunk_amount);
+    region.rows = zpl_min(region.rows, chunk_amount);
+    region.chunk_amount = chunk_amount;
+
+    size_t chunks = zpl_square(chunk_amount);
+    region.chunk_regions = zpl_malloc(sizeof(uint16_t) * chunks);
+    region.chunk_border = zpl_malloc(sizeof(uint8_t) * chunks);
+
+    for (size_t i = 0; i < chunks; i += 1) {
+        int16_t x, y;
+        librg_chunk_to_chunkpos(tracker, (librg_chunk)i, &x, &y, NULL);
+        uint16_t id = region__from_chunkpos(x, y);
+        region.chunk_regions[i] = id;
+        region.chunk_border[i] = 0;
+
+        for (int32_t dy = -REGION_GHOST_CHUNKS; dy <= REGION_GHOST_CHUNKS; dy += 1) {
+            for (int32_t dx = -REGION_GHOST_CHUNKS; dx <= REGION_GHOST_CHUNKS; dx += 1) {
+                int32_t nx = x + dx, ny = y + dy;
+                if (nx < 0 || ny < 0 || nx >= chunk_amount || ny >= chunk_amount) continue;
+                if (region__from_chunkpos(nx, ny) != id) region.chunk_border[i] = 1;
+            }
+        }
+    }
+
+    region.next_report = zpl_time_rel() + REGION_REPORT_RATE;
+
+    if (region_count() > 1) {
+        zpl_printf("[INFO] World is split into %dx%d regions.\n", region.cols, region.rows);
+    }
+}
+
+void region_destroy(void) {
+    zpl_mfree(region.chunk_regions);
+    zpl_mfree(region.chunk_border);
+    region.chunk_regions = NULL;
+    region.chunk_border = NULL;
+}
+
+uint16_t region_count(void) {
+    return region.cols * region.rows;
+}
+
+uint16_t region_from_chunk(librg_chunk chunk) {
+    if (chunk < 0 || chunk >= zpl_square(region.chunk_amount)) return 0;
+    return region.chunk_regions[chunk];
+}
+
+void region_entity_moved(librg_chunk prev, librg_chunk next) {
+    if (region_count() == 1 || !region.chunk_regions) return;
+    if (prev < 0 || next < 0 || next >= zpl_square(region.chunk_amount)) return;
+
+    uint16_t from = region_from_chunk(prev);
+    uint16_t to = region_from_chunk(next);
+
+    if (region.chunk_border[next] && !region.chunk_border[prev]) {
+        region.ghost_entries += 1;
+    }
+
+    if (from != to) {
+        region.crossings += 1;
+    }
+}
+
+void region_update(void) {
+    if (region_count() == 1 || !region.chunk_regions) return;
+    double now = zpl_time_rel();
+
+    if (region.next_report < now) {
+        zpl_printf("[INFO] regions: %.1f crossings/s, %.1f ghost entries/s\n",
+                   region.crossings / REGION_REPORT_RATE, region.ghost_entries / REGION_REPORT_RATE);
+        region.crossings = 0;
+        region.ghost_entries = 0;
+        region.next_report = now + REGION_REPORT_RATE;
+    }
+}
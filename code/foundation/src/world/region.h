@@ -0,0 +1,27 @@
+#pragma once
+#include "platform/system.h"
+#include "librg.h"
+
+// NOTE(zaklaus): Region partitioning
+//
+// Splits the chunk grid into rectangular regions and counts how often entities cross
+// a region border or enter the ghost band near one. Nothing is handed off yet, this only
+// measures how much traffic splitting the world between processes would generate.
+
+// NOTE(zaklaus): entities this close (in chunks) to another region need a ghost copy there
+#define REGION_GHOST_CHUNKS 1
+
+// NOTE(zaklaus): call before world_init, 1x1 disables partitioning
+void region_setup(uint16_t cols, uint16_t rows);
+
+void region_init(librg_world *tracker, uint16_t chunk_amount);
+void region_destroy(void);
+
+uint16_t region_count(void);
+uint16_t region_from_chunk(librg_chunk chunk);
+
+// NOTE(zaklaus): called whenever an entity changes its chunk
+void region_entity_moved(librg_chunk prev, librg_chunk next);
+
+// NOTE(zaklaus): prints the crossing stats every few seconds
+void region_update(void);
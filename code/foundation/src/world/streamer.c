@@ -0,0 +1,546 @@
+#include "zpl.h"
+#include "world/streamer.h"
+#include "world/region.h"
+
+// NOTE(zaklaus): mirrors librg's packed stream layout, librg leaves the flags byte unused
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t type;
+    uint8_t flags;
+    uint16_t amount;
+    uint32_t size;
+} streamer_segment;
+
+typedef struct {
+    uint64_t id;
+    uint16_t token;
+    uint16_t size;
+} streamer_segval;
+
+typedef struct {
+    uint16_t handle;
+    uint16_t size;
+} streamer_handleval;
+#pragma pack(pop)
+
+#define STREAMER_SEGMENT_HANDLES 0x1
+
+typedef enum {
+    STREAMER_VIS_PENDING_REMOVE,
+    STREAMER_VIS_ACTIVE,
+    STREAMER_VIS_PENDING_CREATE,
+    STREAMER_VIS_DROP,
+} streamer_vis_state;
+
+ZPL_TABLE(static, streamer_visible, streamer_visible_, uint8_t);
+ZPL_TABLE(static, streamer_handles, streamer_handles_, uint16_t);
+
+typedef struct {
+    librg_chunk center;
+    uint64_t epoch;
+    streamer_visible visible;
+
+    // NOTE(zaklaus): entity handles, handle 0 stands for no entity
+    streamer_handles handles;
+    int64_t *handle_ents;
+    uint16_t *free_handles;
+
+    // NOTE(zaklaus): bulk budget in bytes, refilled on every full sync
+    float bulk_tokens;
+    double bulk_time;
+} streamer_client;
+
+ZPL_TABLE(static, streamer_clients, streamer_clients_, streamer_client);
+
+static struct {
+    librg_world *tracker;
+    int32_t chunk_count;
+    int64_t **chunk_ents;
+    int64_t *touched;
+    uint64_t epoch;
+    streamer_clients clients;
+    bool handles;
+    size_t largest_value; // NOTE(zaklaus): biggest record written so far, sizes the buffer after an overflow
+    streamer_bulk_proc *bulk_proc;
+    uint32_t bulk_rate;  // bytes per second
+    uint32_t bulk_burst; // bytes
+    streamer_write_proc *create_proc;
+    streamer_write_proc *update_proc;
+    streamer_write_proc *remove_proc;
+} streamer = {0};
+
+void streamer_init(librg_world *tracker, streamer_write_proc *create_proc, streamer_write_proc *update_proc, streamer_write_proc *remove_proc) {
+    uint16_t cx = 0, cy = 0;
+    librg_config_chunkamount_get(tracker, &cx, &cy, NULL);
+
+    streamer.tracker = tracker;
+    streamer.chunk_count = cx * cy;
+    streamer.epoch = 1;
+    streamer.create_proc = create_proc;
+    streamer.update_proc = update_proc;
+    streamer.remove_proc = remove_proc;
+    streamer.chunk_ents = zpl_malloc(sizeof(int64_t*) * streamer.chunk_count);
+
+    for (int32_t i = 0; i < streamer.chunk_count; i += 1) {
+        zpl_array_init(streamer.chunk_ents[i], zpl_heap());
+    }
+
+    zpl_array_init(streamer.touched, zpl_heap());
+    streamer_clients_init(&streamer.clients, zpl_heap());
+}
+
+static void streamer__client_free(streamer_client *client) {
+    streamer_visible_destroy(&client->visible);
+    streamer_handles_destroy(&client->handles);
+    zpl_array_free(client->handle_ents);
+    zpl_array_free(client->free_handles);
+}
+
+static uint16_t streamer__handle_acquire(streamer_client *client, int64_t ent_id) {
+    uint16_t *existing = streamer_handles_get(&client->handles, ent_id);
+    if (existing) return *existing;
+
+    uint16_t handle = 0;
+    if (zpl_array_count(client->free_handles) > 0) {
+        handle = client->free_handles[zpl_array_count(client->free_handles) - 1];
+        zpl_array_pop(client->free_handles);
+        client->handle_ents[handle] = ent_id;
+    } else if (zpl_array_count(client->handle_ents) <= UINT16_MAX) {
+        handle = (uint16_t)zpl_array_count(client->handle_ents);
+        zpl_array_append(client->handle_ents, ent_id);
+    } else {
+        return 0;
+    }
+
+    streamer_handles_set(&client->handles, ent_id, handle);
+    return handle;
+}
+
+static void streamer__handle_release(streamer_client *client, int64_t owner_id, int64_t ent_id) {
+    // NOTE(zaklaus): owner keeps its handle for the whole connection, viewer learns it at welcome time
+    if (ent_id == owner_id) return;
+
+    uint16_t *handle = streamer_handles_get(&client->handles, ent_id);
+    if (!handle) return;
+
+    client->handle_ents[*handle] = 0;
+    zpl_array_append(client->free_handles, *handle);
+    streamer_handles_remove(&client->handles, ent_id);
+}
+
+static streamer_client *streamer__client_get(int64_t owner_id) {
+    streamer_client *client = streamer_clients_get(&streamer.clients, owner_id);
+    if (client) return client;
+
+    streamer_client new_client = {
+        .center = LIBRG_CHUNK_INVALID,
+        .epoch = 0,
+        .bulk_tokens = (float)streamer.bulk_burst,
+        .bulk_time = zpl_time_rel(),
+    };
+    streamer_visible_init(&new_client.visible, zpl_heap());
+    streamer_handles_init(&new_client.handles, zpl_heap());
+    zpl_array_init(new_client.handle_ents, zpl_heap());
+    zpl_array_init(new_client.free_handles, zpl_heap());
+    zpl_array_append(new_client.handle_ents, 0);
+    streamer_clients_set(&streamer.clients, owner_id, new_client);
+
+    client = streamer_clients_get(&streamer.clients, owner_id);
+    streamer__handle_acquire(client, owner_id);
+    return client;
+}
+
+void streamer_setup_handles(bool enabled) {
+    streamer.handles = enabled;
+}
+
+bool streamer_handles_enabled(void) {
+    return streamer.handles;
+}
+
+void streamer_setup_bulk(streamer_bulk_proc *proc, uint32_t rate, uint32_t burst) {
+    streamer.bulk_proc = proc;
+    streamer.bulk_rate = rate;
+    streamer.bulk_burst = burst;
+}
+
+void streamer_client_add(int64_t owner_id) {
+    streamer__client_get(owner_id);
+}
+
+uint16_t streamer_handle_get(int64_t owner_id, int64_t ent_id) {
+    if (!ent_id) return 0;
+    streamer_client *client = streamer_clients_get(&streamer.clients, owner_id);
+    if (!client) return 0;
+    uint16_t *handle = streamer_handles_get(&client->handles, ent_id);
+    return handle ? *handle : 0;
+}
+
+void streamer_destroy(void) {
+    for (int32_t i = 0; i < streamer.chunk_count; i += 1) {
+        zpl_array_free(streamer.chunk_ents[i]);
+    }
+
+    for (zpl_isize i = 0; i < zpl_array_count(streamer.clients.entries); i += 1) {
+        streamer__client_free(&streamer.clients.entries[i].value);
+    }
+
+    zpl_mfree(streamer.chunk_ents);
+    zpl_array_free(streamer.touched);
+    streamer_clients_destroy(&streamer.clients);
+    zpl_memset(&streamer, 0, sizeof(streamer));
+}
+
+static inline bool streamer__chunk_valid(librg_chunk chunk) {
+    return chunk >= 0 && chunk < streamer.chunk_count;
+}
+
+static void streamer__chunk_remove(librg_chunk chunk, int64_t ent_id) {
+    if (!streamer__chunk_valid(chunk)) return;
+    int64_t *ents = streamer.chunk_ents[chunk];
+
+    for (zpl_isize i = 0; i < zpl_array_count(ents); i += 1) {
+        if (ents[i] == ent_id) {
+            ents[i] = ents[zpl_array_count(ents) - 1];
+            zpl_array_pop(ents);
+            return;
+        }
+    }
+}
+
+static void streamer__chunk_add(librg_chunk chunk, int64_t ent_id) {
+    if (!streamer__chunk_valid(chunk)) return;
+    zpl_array_append(streamer.chunk_ents[chunk], ent_id);
+}
+
+void streamer_entity_chunk_set(int64_t ent_id, librg_chunk chunk) {
+    librg_chunk prev = librg_entity_chunk_get(streamer.tracker, ent_id);
+    if (prev == chunk || prev == LIBRG_ENTITY_UNTRACKED) return;
+
+    streamer__chunk_remove(prev, ent_id);
+    streamer__chunk_add(chunk, ent_id);
+    librg_entity_chunk_set(streamer.tracker, ent_id, chunk);
+    zpl_array_append(streamer.touched, ent_id);
+    region_entity_moved(prev, chunk);
+}
+
+void streamer_entity_untrack(int64_t ent_id) {
+    streamer__chunk_remove(librg_entity_chunk_get(streamer.tracker, ent_id), ent_id);
+    zpl_array_append(streamer.touched, ent_id);
+
+    streamer_client *client = streamer_clients_get(&streamer.clients, ent_id);
+    if (client) {
+        streamer__client_free(client);
+        streamer_clients_remove(&streamer.clients, ent_id);
+    }
+}
+
+void streamer_entity_touch(int64_t ent_id) {
+    zpl_array_append(streamer.touched, ent_id);
+}
+
+int64_t *streamer_chunk_entities(librg_chunk chunk, size_t *ents_len) {
+    ZPL_ASSERT_NOT_NULL(ents_len);
+    if (!streamer__chunk_valid(chunk)) {
+        *ents_len = 0;
+        return NULL;
+    }
+    *ents_len = (size_t)zpl_array_count(streamer.chunk_ents[chunk]);
+    return streamer.chunk_ents[chunk];
+}
+
+static bool streamer__in_range(librg_chunk center, librg_chunk chunk, uint8_t radius) {
+    if (!streamer__chunk_valid(center) || !streamer__chunk_valid(chunk)) return false;
+    int16_t ax, ay, bx, by;
+    librg_chunk_to_chunkpos(streamer.tracker, center, &ax, &ay, NULL);
+    librg_chunk_to_chunkpos(streamer.tracker, chunk, &bx, &by, NULL);
+    int32_t dx = bx - ax, dy = by - ay;
+    return dx*dx + dy*dy <= radius*radius;
+}
+
+static bool streamer__is_visible(int64_t owner_id, librg_chunk center, int64_t ent_id, uint8_t radius) {
+    int8_t vis = librg_entity_visibility_global_get(streamer.tracker, ent_id);
+    if (vis < 0) return false; // NOTE(zaklaus): untracked
+    if (ent_id == owner_id) return true;
+    if (vis == LIBRG_VISIBLITY_NEVER) return false;
+    if (vis == LIBRG_VISIBLITY_ALWAYS) return true;
+    return streamer__in_range(center, librg_entity_chunk_get(streamer.tracker, ent_id), radius);
+}
+
+static void streamer__want(streamer_client *client, int64_t ent_id, bool want) {
+    uint8_t *state = streamer_visible_get(&client->visible, ent_id);
+
+    if (want) {
+        if (!state) streamer_visible_set(&client->visible, ent_id, STREAMER_VIS_PENDING_CREATE);
+        else if (*state == STREAMER_VIS_PENDING_REMOVE) *state = STREAMER_VIS_ACTIVE;
+    } else if (state && *state == STREAMER_VIS_ACTIVE) {
+        *state = STREAMER_VIS_PENDING_REMOVE;
+    } else if (state && *state == STREAMER_VIS_PENDING_CREATE) {
+        streamer_visible_remove(&client->visible, ent_id);
+    }
+}
+
+static void streamer__rebuild(streamer_client *client, int64_t owner_id, uint8_t radius) {
+    // NOTE(zaklaus): creates still waiting for room were never sent, they get re-added if still wanted
+    bool dropped = false;
+    for (zpl_isize i = zpl_array_count(client->visible.entries) - 1; i >= 0; i -= 1) {
+        if (client->visible.entries[i].value == STREAMER_VIS_PENDING_CREATE) {
+            streamer_visible_remove_entry(&client->visible, i);
+            dropped = true;
+        }
+    }
+    if (dropped) {
+        streamer_visible_rehash_fast(&client->visible);
+    }
+
+    for (zpl_isize i = 0; i < zpl_array_count(client->visible.entries); i += 1) {
+        client->visible.entries[i].value = STREAMER_VIS_PENDING_REMOVE;
+    }
+
+    streamer__want(client, owner_id, streamer__is_visible(owner_id, client->center, owner_id, radius));
+
+    if (!streamer__chunk_valid(client->center)) return;
+
+    int16_t cx, cy;
+    librg_chunk_to_chunkpos(streamer.tracker, client->center, &cx, &cy, NULL);
+
+    for (int32_t y = -radius; y <= radius; y += 1) {
+        for (int32_t x = -radius; x <= radius; x += 1) {
+            if (x*x + y*y > radius*radius) continue;
+            librg_chunk chunk = librg_chunk_from_chunkpos(streamer.tracker, cx+x, cy+y, 0);
+            if (!streamer__chunk_valid(chunk)) continue;
+
+            int64_t *ents = streamer.chunk_ents[chunk];
+            for (zpl_isize i = 0; i < zpl_array_count(ents); i += 1) {
+                int8_t vis = librg_entity_visibility_global_get(streamer.tracker, ents[i]);
+                streamer__want(client, ents[i], vis != LIBRG_VISIBLITY_NEVER || ents[i] == owner_id);
+            }
+        }
+    }
+}
+
+static void streamer__apply_touched(streamer_client *client, int64_t owner_id, uint8_t radius) {
+    for (zpl_isize i = 0; i < zpl_array_count(streamer.touched); i += 1) {
+        int64_t ent_id = streamer.touched[i];
+        streamer__want(client, ent_id, streamer__is_visible(owner_id, client->center, ent_id, radius));
+    }
+}
+
+typedef struct {
+    char *buffer;
+    size_t limit;
+    size_t written;
+    size_t insufficient;
+} streamer_writer;
+
+typedef enum {
+    STREAMER_WRITE_OK,
+    STREAMER_WRITE_REJECTED,
+    STREAMER_WRITE_NO_SPACE,
+} streamer_write_status;
+
+static streamer_write_status streamer__write_value(streamer_writer *w, streamer_segment *seg, size_t *seg_written, streamer_write_proc *proc, streamer_client *client, int64_t owner_id, int64_t ent_id) {
+    size_t val_size = streamer.handles ? sizeof(streamer_handleval) : sizeof(streamer_segval);
+    size_t offset = w->written + sizeof(streamer_segment) + *seg_written + val_size;
+
+    if (offset >= w->limit || seg->amount == UINT16_MAX) {
+        w->insufficient += offset >= w->limit ? offset - w->limit : 0;
+        return STREAMER_WRITE_NO_SPACE;
+    }
+
+    uint16_t handle = 0;
+    if (streamer.handles) {
+        handle = streamer__handle_acquire(client, ent_id);
+        if (!handle) return STREAMER_WRITE_REJECTED;
+    }
+
+    char *val = w->buffer + offset - val_size;
+    int32_t data_size = proc ? proc(owner_id, ent_id, w->buffer + offset, w->limit - offset) : 0;
+
+    if (data_size == STREAMER_WRITE_OVERFLOW || (data_size >= 0 && (size_t)data_size > w->limit - offset)) {
+        // NOTE(zaklaus): we can't tell how big it would be, assume it's as large as the largest one we've seen
+        w->insufficient += val_size + zpl_max(streamer.largest_value, w->limit - offset + 1);
+        return STREAMER_WRITE_NO_SPACE;
+    }
+    if (data_size < 0) return STREAMER_WRITE_REJECTED;
+    ZPL_ASSERT_MSG(data_size <= UINT16_MAX, "streamer: entity data does not fit into the event buffer");
+
+    if (streamer.handles) {
+        *(streamer_handleval*)val = (streamer_handleval){ .handle = handle, .size = (uint16_t)data_size };
+    } else {
+        *(streamer_segval*)val = (streamer_segval){ .id = (uint64_t)ent_id, .token = ent_id == owner_id, .size = (uint16_t)data_size };
+    }
+
+    streamer.largest_value = zpl_max(streamer.largest_value, (size_t)data_size);
+    *seg_written += val_size + data_size;
+    seg->amount += 1;
+    return STREAMER_WRITE_OK;
+}
+
+static void streamer__write_segment(streamer_writer *w, streamer_client *client, int64_t owner_id, uint8_t radius, uint8_t type) {
+    if (w->written + sizeof(streamer_segment) >= w->limit) {
+        w->insufficient += w->written + sizeof(streamer_segment) - w->limit;
+        return;
+    }
+
+    streamer_segment *seg = (streamer_segment*)(w->buffer + w->written);
+    size_t seg_written = 0;
+    seg->type = type;
+    seg->flags = streamer.handles ? STREAMER_SEGMENT_HANDLES : 0;
+    seg->amount = 0;
+
+    for (zpl_isize i = 0; i < zpl_array_count(client->visible.entries); i += 1) {
+        int64_t ent_id = (int64_t)client->visible.entries[i].key;
+        uint8_t *state = &client->visible.entries[i].value;
+
+        switch (type) {
+            case LIBRG_WRITE_CREATE: {
+                if (*state != STREAMER_VIS_PENDING_CREATE) continue;
+
+                // NOTE(zaklaus): out of bulk budget, the entity waits for the next full sync
+                bool bulk = streamer.bulk_rate > 0 && streamer.bulk_proc && streamer.bulk_proc(ent_id);
+                if (bulk && client->bulk_tokens <= 0.0f) continue;
+
+                size_t seg_before = seg_written;
+                streamer_write_status status = streamer__write_value(w, seg, &seg_written, streamer.create_proc, client, owner_id, ent_id);
+                if (status == STREAMER_WRITE_OK) {
+                    *state = STREAMER_VIS_ACTIVE;
+                    if (bulk) client->bulk_tokens -= (float)(seg_written - seg_before);
+                } else if (status == STREAMER_WRITE_NO_SPACE) {
+                    // NOTE(zaklaus): stays pending, goes out once the buffer has grown
+                    streamer__handle_release(client, owner_id, ent_id);
+                } else {
+                    // NOTE(zaklaus): viewer never got it, retry from scratch next time
+                    *state = STREAMER_VIS_DROP;
+                    client->epoch = 0;
+                    streamer__handle_release(client, owner_id, ent_id);
+                }
+            } break;
+            case LIBRG_WRITE_UPDATE: {
+                if (*state != STREAMER_VIS_ACTIVE) continue;
+                if (!streamer__is_visible(owner_id, client->center, ent_id, radius)) continue;
+                streamer__write_value(w, seg, &seg_written, streamer.update_proc, client, owner_id, ent_id);
+            } break;
+            case LIBRG_WRITE_REMOVE: {
+                if (*state != STREAMER_VIS_PENDING_REMOVE) continue;
+                if (streamer__write_value(w, seg, &seg_written, streamer.remove_proc, client, owner_id, ent_id) != STREAMER_WRITE_OK) {
+                    // NOTE(zaklaus): consider entity alive, till we are able to send it
+                    *state = STREAMER_VIS_ACTIVE;
+                    client->epoch = 0;
+                } else {
+                    *state = STREAMER_VIS_DROP;
+                    streamer__handle_release(client, owner_id, ent_id);
+                }
+            } break;
+        }
+    }
+
+    // NOTE(zaklaus): removing shuffles table entries, so we do it outside of the loop
+    // remove_entry leaves the hash chains dangling, relink them once we are done
+    bool dropped = false;
+    for (zpl_isize i = zpl_array_count(client->visible.entries) - 1; i >= 0; i -= 1) {
+        if (client->visible.entries[i].value == STREAMER_VIS_DROP) {
+            streamer_visible_remove_entry(&client->visible, i);
+            dropped = true;
+        }
+    }
+    if (dropped) {
+        streamer_visible_rehash_fast(&client->visible);
+    }
+
+    if (seg->amount > 0) {
+        seg->size = (uint32_t)seg_written;
+        w->written += sizeof(streamer_segment) + seg_written;
+    }
+}
+
+int32_t streamer_write(int64_t owner_id, uint8_t radius, bool full_sync, char *buffer, size_t *size) {
+    ZPL_ASSERT_NOT_NULL(size);
+    streamer_client *client = streamer__client_get(owner_id);
+    streamer_writer w = { .buffer = buffer, .limit = *size };
+
+    if (full_sync) {
+        librg_chunk center = librg_entity_chunk_get(streamer.tracker, owner_id);
+
+        // NOTE(zaklaus): clients standing still only process membership changes
+        if (client->epoch != streamer.epoch || client->center != center) {
+            client->center = center;
+            streamer__rebuild(client, owner_id, radius);
+        } else {
+            streamer__apply_touched(client, owner_id, radius);
+        }
+
+        // NOTE(zaklaus): considered synced once the current change log gets flushed
+        client->epoch = streamer.epoch + 1;
+
+        if (streamer.bulk_rate > 0) {
+            double now = zpl_time_rel();
+            client->bulk_tokens = zpl_min(client->bulk_tokens + streamer.bulk_rate * (float)(now - client->bulk_time), (float)streamer.bulk_burst);
+            client->bulk_time = now;
+        }
+
+        streamer__write_segment(&w, client, owner_id, radius, LIBRG_WRITE_CREATE);
+        streamer__write_segment(&w, client, owner_id, radius, LIBRG_WRITE_UPDATE);
+        streamer__write_segment(&w, client, owner_id, radius, LIBRG_WRITE_REMOVE);
+    } else {
+        streamer__write_segment(&w, client, owner_id, radius, LIBRG_WRITE_UPDATE);
+    }
+
+    *size = w.written;
+    return (int32_t)w.insufficient;
+}
+
+void streamer_flush(void) {
+    zpl_array_clear(streamer.touched);
+    streamer.epoch += 1;
+}
+
+int32_t streamer_read(char *buffer, size_t size, void *userdata, streamer_read_proc *create_proc, streamer_read_proc *update_proc, streamer_read_proc *remove_proc) {
+    size_t offset = 0;
+    int32_t records = 0;
+
+    while (offset + sizeof(streamer_segment) <= size) {
+        streamer_segment *seg = (streamer_segment*)(buffer + offset);
+        offset += sizeof(streamer_segment);
+
+        if (seg->size > size - offset) return -1;
+        size_t seg_end = offset + seg->size;
+
+        streamer_read_proc *proc = NULL;
+        switch (seg->type) {
+            case LIBRG_WRITE_CREATE: proc = create_proc; break;
+            case LIBRG_WRITE_UPDATE: proc = update_proc; break;
+            case LIBRG_WRITE_REMOVE: proc = remove_proc; break;
+            default: return -2;
+        }
+
+        bool handles = !!(seg->flags & STREAMER_SEGMENT_HANDLES);
+        size_t val_size = handles ? sizeof(streamer_handleval) : sizeof(streamer_segval);
+
+        for (uint16_t i = 0; i < seg->amount; i += 1) {
+            if (val_size > seg_end - offset) return -3;
+
+            int64_t ent_id;
+            size_t data_size;
+            if (handles) {
+                streamer_handleval *val = (streamer_handleval*)(buffer + offset);
+                ent_id = val->handle;
+                data_size = val->size;
+            } else {
+                streamer_segval *val = (streamer_segval*)(buffer + offset);
+                ent_id = (int64_t)val->id;
+                data_size = val->size;
+            }
+            offset += val_size;
+
+            if (data_size > seg_end - offset) return -3;
+            if (proc) proc(userdata, ent_id, buffer + offset, data_size);
+            offset += data_size;
+            records += 1;
+        }
+
+        offset = seg_end;
+    }
+
+    return records;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "platform/system.h"
+#include "librg.h"
+
+// NOTE(zaklaus): Incremental entity streamer
+//
+// Keeps a per-chunk entity index and a per-client visible set, both of which
+// are updated from chunk membership changes instead of re-querying the whole
+// tracker on every write. Output uses librg's stream layout, unless entity
+// handles are enabled, in which case each connection gets its own table of
+// 16-bit handles that replace the 64-bit entity ids on the wire.
+
+#define STREAMER_WRITE_PROC(name) int32_t name(int64_t owner_id, int64_t entity_id, char *buffer, size_t length)
+typedef STREAMER_WRITE_PROC(streamer_write_proc);
+
+// NOTE(zaklaus): write procs return this when the entity does not fit into the space left,
+// the streamer asks for a bigger buffer and retries it on the next pass
+#define STREAMER_WRITE_OVERFLOW (-0x0010)
+
+#define STREAMER_READ_PROC(name) int32_t name(void *userdata, int64_t entity_id, char *buffer, size_t length)
+typedef STREAMER_READ_PROC(streamer_read_proc);
+
+void streamer_init(librg_world *tracker, streamer_write_proc *create_proc, streamer_write_proc *update_proc, streamer_write_proc *remove_proc);
+void streamer_destroy(void);
+
+// NOTE(zaklaus): connection-scoped entity handles, handles are recycled once the viewer was told to remove the entity
+void streamer_setup_handles(bool enabled);
+bool streamer_handles_enabled(void);
+
+// NOTE(zaklaus): bulk entities (chunks) draw their creates from a per-client byte budget,
+// once it is spent they stay pending until the client has caught up, rate of 0 lifts the limit
+#define STREAMER_BULK_PROC(name) bool name(int64_t entity_id)
+typedef STREAMER_BULK_PROC(streamer_bulk_proc);
+
+void streamer_setup_bulk(streamer_bulk_proc *proc, uint32_t rate, uint32_t burst);
+
+// NOTE(zaklaus): registers the connection and reserves the owner's handle
+void streamer_client_add(int64_t owner_id);
+
+// NOTE(zaklaus): returns the handle of an entity within the owner's connection, 0 if it has none
+uint16_t streamer_handle_get(int64_t owner_id, int64_t ent_id);
+
+// NOTE(zaklaus): chunk membership changes
+void streamer_entity_chunk_set(int64_t ent_id, librg_chunk chunk);
+void streamer_entity_untrack(int64_t ent_id);
+void streamer_entity_touch(int64_t ent_id);
+
+// NOTE(zaklaus): returns entities currently residing in a chunk, do not hold on to the pointer
+int64_t *streamer_chunk_entities(librg_chunk chunk, size_t *ents_len);
+
+// NOTE(zaklaus): writes updates for entities within radius, full_sync also derives create/remove lists
+// returns the amount of bytes we were missing in the buffer, same as librg_world_write
+int32_t streamer_write(int64_t owner_id, uint8_t radius, bool full_sync, char *buffer, size_t *size);
+
+// NOTE(zaklaus): drops the recorded membership changes once all clients were synced
+void streamer_flush(void);
+
+// NOTE(zaklaus): decodes a stream produced by streamer_write, entity ids are handles if the server used them
+// returns the amount of records read or a negative value if the stream is malformed
+int32_t streamer_read(char *buffer, size_t size, void *userdata, streamer_read_proc *create_proc, streamer_read_proc *update_proc, streamer_read_proc *remove_proc);
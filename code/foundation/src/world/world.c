@@ -4,6 +4,8 @@
 #include "systems/systems.h"
 #include "world/world.h"
 #include "world/entity_view.h"
+#include "world/streamer.h"
+#include "world/region.h"
 #include "dev/debug_replay.h"
 #include "models/items.h"
 #include "world/worldgen.h"
@@ -21,10 +23,41 @@
 ZPL_TABLE(static, world_snapshot, world_snapshot_, entity_view);
 
 static world_data world = { 0 };
-static world_snapshot streamer_snapshot;
+
+// NOTE(zaklaus): kept outside of world_data, it is configured before the world gets created
+static struct {
+    uint16_t rate;
+    uint8_t max_substeps;
+    double accumulator;
+    double last_time;
+    float alpha;
+    uint64_t dropped_steps;
+} world_sim = {
+    .rate = WORLD_SIM_DEFAULT_RATE,
+    .max_substeps = WORLD_SIM_DEFAULT_SUBSTEPS,
+    .alpha = 1.0f,
+};
+
+// NOTE(zaklaus): never catch up on more than this, e.g. after a breakpoint or a long world save
+#define WORLD_SIM_MAX_FRAME_TIME 0.25
+
+// NOTE(zaklaus): entity views built during a tracker pass are cached in the back snapshot,
+// direct transport publishes it as the front one which stays intact until the next pass
+static world_snapshot streamer_snapshots[2];
+static world_snapshot *streamer_snapshot = &streamer_snapshots[0];
+static world_snapshot *direct_snapshot = &streamer_snapshots[1];
+
+typedef struct {
+    uint16_t view_id;
+    size_t offset;
+    size_t size;
+} world_direct_update;
+
+static zpl_array(uint8_t) direct_stream;
+static zpl_array(world_direct_update) direct_updates;
 
 entity_view* world_build_entity_view(int64_t e) {
-    entity_view* cached_ev = world_snapshot_get(&streamer_snapshot, e);
+    entity_view* cached_ev = world_snapshot_get(streamer_snapshot, e);
     if (cached_ev) return cached_ev;
 
     entity_view view = { 0 };
@@ -157,40 +190,58 @@ entity_view* world_build_entity_view(int64_t e) {
         }
     }
 
-    world_snapshot_set(&streamer_snapshot, e, view);
-    return world_snapshot_get(&streamer_snapshot, e);
+    world_snapshot_set(streamer_snapshot, e, view);
+    return world_snapshot_get(streamer_snapshot, e);
 }
 
-int32_t tracker_write_create(librg_world* w, librg_event* e) {
-    int64_t entity_id = librg_event_entity_get(w, e);
-#ifdef WORLD_LAYERING
-    if (world.active_layer_id != WORLD_TRACKER_LAYERS - 1) {
-        // NOTE(zaklaus): reject updates from smaller layers
-        return LIBRG_WRITE_REJECT;
+static int32_t tracker_pack_entity_view(int64_t owner_id, entity_view *view, char *buffer, size_t length) {
+    size_t size = 0;
+
+    // NOTE(zaklaus): views are shared between connections, entity references get translated per connection
+    if (streamer_handles_enabled() && (view->pick_ent || view->sel_ent)) {
+        entity_view data = *view;
+        data.pick_ent = world_entity_wire_id(owner_id, (int64_t)view->pick_ent);
+        data.sel_ent = world_entity_wire_id(owner_id, (int64_t)view->sel_ent);
+        size = entity_view_pack_struct(pkt_ctx_local(), buffer, length, &data);
+    } else {
+        size = entity_view_pack_struct(pkt_ctx_local(), buffer, length, view);
     }
-#endif
-    size_t actual_length = librg_event_size_get(w, e);
-    char* buffer = librg_event_buffer_get(w, e);
 
-    return (int32_t)entity_view_pack_struct(buffer, actual_length, world_build_entity_view(entity_id));
+    // NOTE(zaklaus): a cut-off view is worse than none, let the streamer retry it with a bigger buffer
+    if (size == 0 || size > INT32_MAX) return STREAMER_WRITE_OVERFLOW;
+    return (int32_t)size;
 }
 
-int32_t tracker_write_remove(librg_world* w, librg_event* e) {
-    (void)e;
-    (void)w;
-#ifdef WORLD_LAYERING
-    if (world.active_layer_id != WORLD_TRACKER_LAYERS - 1) {
-        // NOTE(zaklaus): reject updates from smaller layers
-        return LIBRG_WRITE_REJECT;
+STREAMER_WRITE_PROC(tracker_write_create) {
+    entity_view* view = world_build_entity_view(entity_id);
+
+    // NOTE(zaklaus): local viewers pick the view up from the published snapshot
+    if (world.direct_transport) {
+        return 0;
     }
-#endif
+
+    return tracker_pack_entity_view(owner_id, view, buffer, length);
+}
+
+STREAMER_WRITE_PROC(tracker_write_remove) {
+    (void)owner_id;
+    (void)entity_id;
+    (void)buffer;
+    (void)length;
     return 0;
 }
 
-int32_t tracker_write_update(librg_world* w, librg_event* e) {
-    int64_t entity_id = librg_event_entity_get(w, e);
-    size_t actual_length = librg_event_size_get(w, e);
-    char* buffer = librg_event_buffer_get(w, e);
+STREAMER_WRITE_PROC(tracker_write_update) {
+    // NOTE(zaklaus): action-based updates, checked before we spend time building the view
+#if ECO2D_STREAM_ACTIONFILTER
+    {
+        const Classify *c = ecs_get(world.ecs, entity_id, Classify);
+        if ((!c || c->id != EKIND_CHUNK) && !entity_can_stream(entity_id)) {
+            return LIBRG_WRITE_REJECT;
+        }
+    }
+#endif
+
     entity_view* view = world_build_entity_view(entity_id);
 
     // NOTE(zaklaus): exclude chunks from updates as they never move
@@ -200,16 +251,11 @@ int32_t tracker_write_update(librg_world* w, librg_event* e) {
         }
     }
 
-    // NOTE(zaklaus): action-based updates
-#if ECO2D_STREAM_ACTIONFILTER
-    {
-        if (view->kind != EKIND_CHUNK && !entity_can_stream(entity_id)) {
-            return LIBRG_WRITE_REJECT;
-        }
+    if (world.direct_transport) {
+        return 0;
     }
-#endif
 
-    return (int32_t)entity_view_pack_struct(buffer, actual_length, view);
+    return tracker_pack_entity_view(owner_id, view, buffer, length);
 }
 
 void world_setup_pkt_handlers(world_pkt_reader_proc* reader_proc, world_pkt_writer_proc* writer_proc) {
@@ -217,6 +263,58 @@ void world_setup_pkt_handlers(world_pkt_reader_proc* reader_proc, world_pkt_writ
     world.writer_proc = writer_proc;
 }
 
+void world_setup_pkt_alloc(world_pkt_alloc_proc* alloc_proc) {
+    world.alloc_proc = alloc_proc;
+}
+
+void world_setup_direct_transport(bool enabled) {
+    world.direct_transport = enabled;
+
+    if (enabled && !direct_stream) {
+        zpl_array_init(direct_stream, zpl_heap());
+        zpl_array_init(direct_updates, zpl_heap());
+    }
+    else if (!enabled && direct_stream) {
+        zpl_array_free(direct_stream);
+        zpl_array_free(direct_updates);
+        direct_stream = NULL;
+        direct_updates = NULL;
+    }
+}
+
+void world_setup_entity_handles(bool enabled) {
+    streamer_setup_handles(enabled);
+}
+
+static STREAMER_BULK_PROC(tracker_is_chunk) {
+    const Classify *c = ecs_get(world.ecs, entity_id, Classify);
+    return c && c->id == EKIND_CHUNK;
+}
+
+void world_setup_chunk_quota(bool enabled) {
+    streamer_setup_bulk(tracker_is_chunk, enabled ? WORLD_CHUNK_RATE : 0, WORLD_CHUNK_BURST);
+}
+
+void world_entity_handles_add_owner(int64_t owner_id) {
+    if (streamer_handles_enabled()) {
+        streamer_client_add(owner_id);
+    }
+}
+
+uint64_t world_entity_wire_id(int64_t owner_id, int64_t ent_id) {
+    if (!streamer_handles_enabled()) {
+        return (uint64_t)ent_id;
+    }
+    return streamer_handle_get(owner_id, ent_id);
+}
+
+entity_view* world_direct_view_get(int64_t ent_id) {
+    if (!world.direct_transport) {
+        return NULL;
+    }
+    return world_snapshot_get(direct_snapshot, ent_id);
+}
+
 void world_rebuild_chunk_islands(librg_chunk chunk_id) {
     int16_t ch_x, ch_y;
     librg_chunk_to_chunkpos(world.tracker, chunk_id, &ch_x, &ch_y, NULL);
@@ -257,6 +355,22 @@ void world_rebuild_chunk_islands(librg_chunk chunk_id) {
     }
 }
 
+static inline
+void world_chunk_update_collision(int64_t id, uint16_t block_idx) {
+    block_id bid = world.outer_block_mapping[id][block_idx];
+    if (bid == 0) {
+        bid = world.block_mapping[id][block_idx];
+    }
+
+    uint64_t *words = world.collision_bits + id * world.collision_words;
+    uint64_t mask = 1ull << (block_idx & 63);
+    if (blocks_get_flags(bid) & BLOCK_FLAG_COLLISION) {
+        words[block_idx >> 6] |= mask;
+    } else {
+        words[block_idx >> 6] &= ~mask;
+    }
+}
+
 static inline
 void world_chunk_setup_grid(void) {
     for (int i = 0; i < zpl_square(world.chunk_amount); ++i) {
@@ -264,7 +378,7 @@ void world_chunk_setup_grid(void) {
         ecs_set(world.ecs, e, Classify, { .id = EKIND_CHUNK });
         Chunk* chunk = ecs_get_mut(world.ecs, e, Chunk);
         librg_entity_track(world.tracker, e);
-        librg_entity_chunk_set(world.tracker, e, i);
+        streamer_entity_chunk_set(e, i);
         librg_chunk_to_chunkpos(world.tracker, i, &chunk->x, &chunk->y, NULL);
         world.chunk_mapping[i] = e;
         world.block_mapping[i] = zpl_malloc(sizeof(block_id) * zpl_square(world.chunk_size));
@@ -286,6 +400,10 @@ void world_chunk_setup_grid(void) {
         }
 
         world_rebuild_chunk_islands(i);
+
+        for (uint16_t b = 0; b < zpl_square(world.chunk_size); b += 1) {
+            world_chunk_update_collision(i, b);
+        }
     }
 }
 
@@ -301,9 +419,8 @@ void world_configure_tracker(void) {
     librg_config_chunkamount_set(world.tracker, world.chunk_amount, world.chunk_amount, 0);
     librg_config_chunkoffset_set(world.tracker, LIBRG_OFFSET_BEG, LIBRG_OFFSET_BEG, LIBRG_OFFSET_BEG);
 
-    librg_event_set(world.tracker, LIBRG_WRITE_CREATE, tracker_write_create);
-    librg_event_set(world.tracker, LIBRG_WRITE_REMOVE, tracker_write_remove);
-    librg_event_set(world.tracker, LIBRG_WRITE_UPDATE, tracker_write_update);
+    streamer_init(world.tracker, tracker_write_create, tracker_write_update, tracker_write_remove);
+    region_init(world.tracker, world.chunk_amount);
 
     /* config our collision grid */
     uint16_t chks = world.chunk_size / 2;
@@ -340,7 +457,11 @@ void world_init_mapping(void) {
     world.outer_block_mapping = zpl_malloc(sizeof(block_id*) * zpl_square(world.chunk_amount));
     world.islands_count = zpl_malloc(sizeof(world.islands_count[0]) * zpl_square(world.chunk_amount));
     world.islands = zpl_malloc(sizeof(collision_island) * 16 * zpl_square(world.chunk_amount));
-    world_snapshot_init(&streamer_snapshot, zpl_heap());
+    world.collision_words = (uint16_t)((zpl_square(world.chunk_size) + 63) / 64);
+    world.collision_bits = zpl_malloc(sizeof(uint64_t) * world.collision_words * zpl_square(world.chunk_amount));
+    zpl_memset(world.collision_bits, 0, sizeof(uint64_t) * world.collision_words * zpl_square(world.chunk_amount));
+    world_snapshot_init(&streamer_snapshots[0], zpl_heap());
+    world_snapshot_init(&streamer_snapshots[1], zpl_heap());
 }
 
 static inline
@@ -387,6 +508,8 @@ int32_t world_init(int32_t seed, uint16_t chunk_size, uint16_t chunk_amount) {
 }
 
 int32_t world_destroy(void) {
+    streamer_destroy();
+    region_destroy();
     librg_world_destroy(world.collision_grid);
     librg_world_destroy(world.tracker);
     ecs_fini(world.ecs);
@@ -399,7 +522,10 @@ int32_t world_destroy(void) {
     zpl_mfree(world.outer_block_mapping);
     zpl_mfree(world.islands_count);
     zpl_mfree(world.islands);
-    world_snapshot_destroy(&streamer_snapshot);
+    zpl_mfree(world.collision_bits);
+    world_snapshot_destroy(&streamer_snapshots[0]);
+    world_snapshot_destroy(&streamer_snapshots[1]);
+    world_setup_direct_transport(false);
     zpl_memset(&world, 0, sizeof(world));
 
     zpl_printf("[INFO] World was destroyed.\n");
@@ -407,8 +533,45 @@ int32_t world_destroy(void) {
 }
 
 #define WORLD_LIBRG_BUFSIZ 2000000
+#define WORLD_LIBRG_MINSIZ 4096
 #define WORLD_MAX_OVERRIDABLES 8192
 
+static size_t world_tracker_stream_size(ClientInfo *p, uint8_t ticker, int32_t result, size_t datalen) {
+    if (result > 0) {
+        if (datalen + result > WORLD_LIBRG_BUFSIZ) {
+            zpl_printf("[info] buffer size was not enough, please increase it by at least: %d\n", result);
+        }
+        return datalen + result;
+    }
+    else if (result < 0) {
+        zpl_printf("[error] an error happened writing the world %d\n", result);
+        return p->stream_size[ticker];
+    }
+    return datalen;
+}
+
+// NOTE(zaklaus): direct transport keeps the streams around until the views are published
+static void world_tracker_write_direct(ClientInfo *p, int64_t owner_id, uint8_t ticker, uint8_t radius, bool full_sync) {
+    size_t datalen = zpl_clamp(p->stream_size[ticker] * 2, WORLD_LIBRG_MINSIZ, WORLD_LIBRG_BUFSIZ);
+    size_t offset = zpl_array_count(direct_stream);
+    zpl_array_resize(direct_stream, (zpl_isize)(offset + datalen));
+
+    int32_t result = streamer_write(owner_id, radius, full_sync, (char*)direct_stream + offset, &datalen);
+    p->stream_size[ticker] = (uint32_t)world_tracker_stream_size(p, ticker, result, datalen);
+
+    zpl_array_resize(direct_stream, (zpl_isize)(offset + datalen));
+    zpl_array_append(direct_updates, ((world_direct_update){ .view_id = p->view_id, .offset = offset, .size = datalen }));
+}
+
+static void world_tracker_deliver_direct(uint8_t ticker) {
+    for (zpl_isize i = 0; i < zpl_array_count(direct_updates); i++) {
+        world_direct_update *u = &direct_updates[i];
+        pkt_send_librg_update_apply(u->view_id, ticker, direct_stream + u->offset, u->size);
+    }
+    zpl_array_clear(direct_stream);
+    zpl_array_clear(direct_updates);
+}
+
 static void world_tracker_update(uint8_t ticker, float freq, uint8_t radius) {
     if (world.tracker_update[ticker] > (float)(get_cached_time())) return;
     world.tracker_update[ticker] = (float)(get_cached_time()) + freq;
@@ -416,9 +579,15 @@ static void world_tracker_update(uint8_t ticker, float freq, uint8_t radius) {
     profile(PROF_WORLD_WRITE) {
 		// move along to standard streaming
         ecs_iter_t it = ecs_query_iter(world_ecs(), world.ecs_update);
-        static char buffer[WORLD_LIBRG_BUFSIZ] = { 0 };
         world.active_layer_id = ticker;
 
+#ifdef WORLD_LAYERING
+        // NOTE(zaklaus): creates/removes are only derived on the last layer
+        bool full_sync = (ticker == WORLD_TRACKER_LAYERS - 1);
+#else
+        bool full_sync = true;
+#endif
+
 		// temporary storage for overridables
 		static struct overridable_pair {
 			uint64_t e;
@@ -451,21 +620,28 @@ static void world_tracker_update(uint8_t ticker, float freq, uint8_t radius) {
             ClientInfo* p = ecs_field(&it, ClientInfo, 1);
 
             for (int i = 0; i < it.count; i++) {
-                size_t datalen = WORLD_LIBRG_BUFSIZ;
-
                 if (!p[i].active)
                     continue;
 
-                int32_t result = librg_world_write(world_tracker(), it.entities[i], radius, buffer, &datalen, NULL);
-
-                if (result > 0) {
-                    zpl_printf("[info] buffer size was not enough, please increase it by at least: %d\n", result);
+                if (world.direct_transport) {
+                    world_tracker_write_direct(&p[i], it.entities[i], ticker, radius, full_sync);
+                    continue;
                 }
-                else if (result < 0) {
-                    zpl_printf("[error] an error happened writing the world %d\n", result);
+
+                // NOTE(zaklaus): leave room to grow, unused capacity is never sent
+                size_t datalen = zpl_clamp(p[i].stream_size[ticker] * 2, WORLD_LIBRG_MINSIZ, WORLD_LIBRG_BUFSIZ);
+                pkt_header pkt;
+                char *buffer = (char*)pkt_send_librg_update_begin(pkt_ctx_local(), &pkt, p[i].view_id, ticker, p[i].input_seq, full_sync, datalen);
+
+                if (!buffer) {
+                    zpl_printf("[error] could not allocate a world update packet of size %zu\n", datalen);
+                    continue;
                 }
 
-                pkt_send_librg_update((uint64_t)p[i].peer, p[i].view_id, ticker, buffer, datalen);
+                int32_t result = streamer_write(it.entities[i], radius, full_sync, buffer, &datalen);
+                p[i].stream_size[ticker] = (uint32_t)world_tracker_stream_size(&p[i], ticker, result, datalen);
+
+                pkt_send_librg_update_commit(&pkt, (uint64_t)p[i].peer, datalen);
             }
         }
 
@@ -474,13 +650,61 @@ static void world_tracker_update(uint8_t ticker, float freq, uint8_t radius) {
 			librg_entity_visibility_global_set(world.tracker, overridables[i].e, overridables[i].state);
 		}
 
-        world_snapshot_clear(&streamer_snapshot);
+        if (full_sync) {
+            streamer_flush();
+        }
+
+        // NOTE(zaklaus): publish the views we just built, the old front becomes the next back buffer
+        if (world.direct_transport) {
+            world_snapshot *published = streamer_snapshot;
+            streamer_snapshot = direct_snapshot;
+            direct_snapshot = published;
+        }
+
+        world_snapshot_clear(streamer_snapshot);
+
+        if (world.direct_transport) {
+            world_tracker_deliver_direct(ticker);
+        }
+    }
+}
+
+static void world_sim_advance(void) {
+    double now = zpl_time_rel();
+    double frame_time = world_sim.last_time > 0.0 ? now - world_sim.last_time : 0.0;
+    world_sim.last_time = now;
+
+    if (!world_sim.rate || world.is_paused) {
+        world_sim.accumulator = 0.0;
+        world_sim.alpha = 1.0f;
+        ecs_progress(world.ecs, 0.0f);
+        return;
+    }
+
+    double step = 1.0 / world_sim.rate;
+    world_sim.accumulator += zpl_min(frame_time, WORLD_SIM_MAX_FRAME_TIME);
+
+    uint8_t substeps = 0;
+    while (world_sim.accumulator >= step) {
+        if (substeps == world_sim.max_substeps) {
+            // NOTE(zaklaus): we can't keep up, drop the backlog and keep the partial step
+            uint64_t dropped = (uint64_t)(world_sim.accumulator / step);
+            world_sim.dropped_steps += dropped;
+            world_sim.accumulator -= dropped * step;
+            break;
+        }
+
+        ecs_progress(world.ecs, (float)step);
+        world_sim.accumulator -= step;
+        substeps++;
     }
+
+    world_sim.alpha = (float)(world_sim.accumulator / step);
 }
 
 int32_t world_update() {
     profile(PROF_UPDATE_SYSTEMS) {
-        ecs_progress(world.ecs, 0.0f);
+        world_sim_advance();
     }
 
     float fast_ms = WORLD_TRACKER_UPDATE_MP_FAST_MS;
@@ -498,6 +722,7 @@ int32_t world_update() {
     world_tracker_update(0, fast_ms, 1);
     world_tracker_update(1, normal_ms, 2);
     world_tracker_update(2, slow_ms, 3);
+    region_update();
 
     entity_update_action_timers();
     debug_replay_update();
@@ -505,10 +730,34 @@ int32_t world_update() {
 }
 
 int32_t world_read(void* data, uint32_t datalen, void* udata) {
-    if (world.reader_proc) {
+    if (!world.reader_proc) {
+        return -1;
+    }
+
+    uint8_t* buf = (uint8_t*)data;
+
+    if (datalen == 0 || buf[0] != PKT_BATCH_MARKER) {
         return world.reader_proc(data, datalen, udata);
     }
-    return -1;
+
+    // NOTE(zaklaus): split coalesced datagram into individual messages
+    int32_t result = 1;
+    uint32_t offset = 1;
+
+    while (offset + PKT_BATCH_FRAME_SIZE <= datalen) {
+        uint32_t frame_len = (uint32_t)buf[offset] | ((uint32_t)buf[offset + 1] << 8);
+        offset += PKT_BATCH_FRAME_SIZE;
+
+        if (offset + frame_len > datalen) {
+            return 0; // truncated frame
+        }
+
+        int32_t state = world.reader_proc(buf + offset, frame_len, udata);
+        if (state <= 0) result = state;
+        offset += frame_len;
+    }
+
+    return offset == datalen ? result : 0;
 }
 
 int32_t world_write(pkt_header* pkt, void* udata) {
@@ -518,6 +767,15 @@ int32_t world_write(pkt_header* pkt, void* udata) {
     return -1;
 }
 
+uint8_t* world_alloc(pkt_header* pkt, size_t size) {
+    if (world.alloc_proc) {
+        return world.alloc_proc(pkt, size);
+    }
+
+    // NOTE(zaklaus): local transport reads straight from the context's scratch buffer
+    return (pkt->ctx && size > 0 && size <= PKT_BUFSIZ) ? pkt->ctx->buffer : NULL;
+}
+
 uint32_t world_buf(block_id const** ptr, uint32_t* width) {
     ZPL_ASSERT_NOT_NULL(world.data);
     ZPL_ASSERT_NOT_NULL(ptr);
@@ -581,6 +839,23 @@ void world_step(float step_size) {
     world_pause();
 }
 
+void world_setup_sim_rate(uint16_t rate, uint8_t max_substeps) {
+    world_sim.rate = rate;
+    world_sim.max_substeps = zpl_max(max_substeps, 1);
+}
+
+float world_sim_step_size(void) {
+    return world_sim.rate ? 1.0f / world_sim.rate : 0.0f;
+}
+
+uint64_t world_sim_dropped_steps(void) {
+    return world_sim.dropped_steps;
+}
+
+float world_sim_alpha(void) {
+    return world_sim.alpha;
+}
+
 uint16_t world_chunk_size(void) {
     return world.chunk_size;
 }
@@ -661,6 +936,13 @@ void world_chunk_destroy_block(float x, float y, bool drop_item) {
     }
 }
 
+bool world_block_is_solid(int32_t bx, int32_t by) {
+    if (bx < 0 || by < 0 || bx >= world.dim || by >= world.dim) return true;
+    int32_t id = (by / world.chunk_size) * world.chunk_amount + (bx / world.chunk_size);
+    int32_t block_idx = (by % world.chunk_size) * world.chunk_size + (bx % world.chunk_size);
+    return (world.collision_bits[id * world.collision_words + (block_idx >> 6)] >> (block_idx & 63)) & 1;
+}
+
 world_block_lookup world_block_from_index(int64_t id, uint16_t block_idx) {
     block_id bid = world.outer_block_mapping[id][block_idx];
     if (bid == 0) {
@@ -706,10 +988,34 @@ int64_t world_chunk_from_entity(ecs_entity_t id) {
     return librg_entity_chunk_get(world.tracker, id);
 }
 
+// NOTE(zaklaus): bodies resting next to a changed block might have lost their support, wake them up
+static void world_chunk_wake_bodies(int64_t id, uint16_t block_idx) {
+    world_block_lookup l = world_block_from_index(id, block_idx);
+    int16_t chunk_x, chunk_y;
+    librg_chunk_to_chunkpos(world.tracker, id, &chunk_x, &chunk_y, NULL);
+
+    for (int16_t y = chunk_y - 1; y <= chunk_y + 1; y++) {
+        for (int16_t x = chunk_x - 1; x <= chunk_x + 1; x++) {
+            librg_chunk ch = librg_chunk_from_chunkpos(world.tracker, x, y, 0);
+            if (ch == LIBRG_CHUNK_INVALID) continue;
+
+            size_t ents_len;
+            int64_t *ents = streamer_chunk_entities(ch, &ents_len);
+            for (size_t i = 0; i < ents_len; i++) {
+                if (!ecs_has(world_ecs(), ents[i], Sleeping)) continue;
+                const Position *p = ecs_get(world_ecs(), ents[i], Position);
+                if (zpl_abs(p->x - l.ox) > WORLD_BLOCK_SIZE*2 || zpl_abs(p->y - l.oy) > WORLD_BLOCK_SIZE*2) continue;
+                entity_wake(ents[i]);
+            }
+        }
+    }
+}
+
 void world_chunk_replace_worldgen_block(int64_t id, uint16_t block_idx, block_id bid) {
     ZPL_ASSERT(block_idx < zpl_square(world.chunk_size));
     ZPL_ASSERT(!(blocks_get_flags(bid) & BLOCK_FLAG_ENTITY));
     world.block_mapping[id][block_idx] = bid;
+    world_chunk_update_collision(id, block_idx);
     world_chunk_mark_dirty(world.chunk_mapping[id]);
 }
 
@@ -722,7 +1028,9 @@ void world_chunk_replace_block(int64_t id, uint16_t block_idx, block_id bid) {
     }
     else {
         world.outer_block_mapping[id][block_idx] = bid;
+        world_chunk_update_collision(id, block_idx);
         world_chunk_mark_dirty(world.chunk_mapping[id]);
+        world_chunk_wake_bodies(id, block_idx);
     }
 }
 
@@ -736,7 +1044,9 @@ bool world_chunk_place_block(int64_t id, uint16_t block_idx, block_id bid) {
     }
     else {
         world.outer_block_mapping[id][block_idx] = bid;
+        world_chunk_update_collision(id, block_idx);
         world_chunk_mark_dirty(world.chunk_mapping[id]);
+        world_chunk_wake_bodies(id, block_idx);
     }
     return true;
 }
@@ -761,8 +1071,9 @@ bool world_chunk_is_dirty(ecs_entity_t e) {
 int64_t* world_chunk_fetch_entities(librg_chunk chunk_id, size_t* ents_len) {
     ZPL_ASSERT_NOT_NULL(ents_len);
     static int64_t ents[UINT16_MAX];
-    *ents_len = UINT16_MAX;
-    librg_world_fetch_chunk(world.tracker, chunk_id, ents, ents_len);
+    int64_t *chunk_ents = streamer_chunk_entities(chunk_id, ents_len);
+    *ents_len = zpl_min(*ents_len, UINT16_MAX);
+    zpl_memcopy(ents, chunk_ents, sizeof(int64_t) * (*ents_len));
     return ents;
 }
 
@@ -29,6 +29,10 @@ typedef WORLD_PKT_READER(world_pkt_reader_proc);
 #define WORLD_PKT_WRITER(name) int32_t name(pkt_header *pkt, void *udata)
 typedef WORLD_PKT_WRITER(world_pkt_writer_proc);
 
+// NOTE(zaklaus): provides buffers for in-place packets, size 0 releases an unsent one
+#define WORLD_PKT_ALLOC(name) uint8_t *name(pkt_header *pkt, size_t size)
+typedef WORLD_PKT_ALLOC(world_pkt_alloc_proc);
+
 typedef struct {
 	float minx, miny;
 	float maxx, maxy;
@@ -47,6 +51,8 @@ typedef struct {
     uint16_t dim;
 	uint8_t *islands_count;
 	collision_island *islands;
+    uint64_t *collision_bits; // per chunk, one bit per block with BLOCK_FLAG_COLLISION
+    uint16_t collision_words;
     float tracker_update[3];
     uint8_t active_layer_id;
     ecs_world_t *ecs;
@@ -59,15 +65,41 @@ typedef struct {
     librg_world *tracker, *collision_grid;
     world_pkt_reader_proc *reader_proc;
     world_pkt_writer_proc *writer_proc;
+    world_pkt_alloc_proc *alloc_proc;
+    bool direct_transport;
 } world_data;
 
 void world_setup_pkt_handlers(world_pkt_reader_proc *reader_proc, world_pkt_writer_proc *writer_proc);
+void world_setup_pkt_alloc(world_pkt_alloc_proc *alloc_proc);
+
+// NOTE(zaklaus): in-process viewers receive entity views straight from a published snapshot,
+// world updates then only carry the stream layout without any entity data
+void world_setup_direct_transport(bool enabled);
+struct entity_view *world_direct_view_get(int64_t ent_id);
+
+// NOTE(zaklaus): remote viewers address entities by connection-scoped 16-bit handles,
+// anything referring to an entity on the wire has to go through world_entity_wire_id
+void world_setup_entity_handles(bool enabled);
+void world_entity_handles_add_owner(int64_t owner_id);
+uint64_t world_entity_wire_id(int64_t owner_id, int64_t ent_id);
+
+// NOTE(zaklaus): chunk creates going to remote viewers are rate limited per connection,
+// entity creates/updates/removes are never held back
+#ifndef WORLD_CHUNK_RATE
+#define WORLD_CHUNK_RATE (256*1024)
+#endif
+#ifndef WORLD_CHUNK_BURST
+#define WORLD_CHUNK_BURST (96*1024) // NOTE(zaklaus): covers a slow layer pass at full rate
+#endif
+void world_setup_chunk_quota(bool enabled);
+
 int32_t world_init(int32_t seed, uint16_t chunk_size, uint16_t chunk_amount);
 int32_t world_destroy(void);
 int32_t world_update(void);
 
 int32_t world_read(void* data, uint32_t datalen, void *udata);
 int32_t world_write(pkt_header *pkt, void *udata);
+uint8_t *world_alloc(pkt_header *pkt, size_t size);
 
 uint32_t world_buf(block_id const **ptr, uint32_t *width);
 uint32_t world_seed(void);
@@ -85,6 +117,19 @@ void world_resume(void);
 bool world_is_paused(void);
 void world_step(float step_size);
 
+// NOTE(zaklaus): fixed simulation step, world_update runs as many steps as the elapsed time asks for,
+// up to max_substeps per call, the rest is dropped and the simulation slows down instead.
+// A rate of 0 steps the simulation once per update with the frame's delta time.
+#define WORLD_SIM_DEFAULT_RATE 60
+#define WORLD_SIM_DEFAULT_SUBSTEPS 4
+void world_setup_sim_rate(uint16_t rate, uint8_t max_substeps);
+float world_sim_step_size(void);
+uint64_t world_sim_dropped_steps(void);
+
+// NOTE(zaklaus): how far we are between the last simulated step and the next one, 0..1,
+// viewers use it to blend between the previous and the current state
+float world_sim_alpha(void);
+
 uint16_t world_chunk_size(void);
 uint16_t world_chunk_amount(void);
 uint16_t world_dim(void);
@@ -103,6 +148,9 @@ typedef struct {
 } world_block_lookup;
 
 world_block_lookup world_block_from_realpos(float x, float y);
+
+// NOTE(zaklaus): global block coordinates, anything outside of the world is solid
+bool world_block_is_solid(int32_t bx, int32_t by);
 world_block_lookup world_block_from_index(int64_t id, uint16_t block_idx);
 int64_t world_chunk_from_realpos(float x, float y);
 int64_t world_chunk_from_entity(ecs_entity_t id);
@@ -4,13 +4,24 @@
 #include "world/prediction.h"
 #include "librg.h"
 #include "world/world.h"
+#include "world/streamer.h"
 #include "core/game.h"
 
 #include <math.h>
 
-int32_t tracker_read_remove(librg_world *w, librg_event *e) {
-    int64_t entity_id = librg_event_entity_get(w, e);
-    world_view *view = (world_view*)librg_world_userdata_get(w);
+// NOTE(zaklaus): direct transport hands us the server's view, there is nothing to decode
+static entity_view tracker_read_entity_view(int64_t entity_id, char *buffer, size_t actual_length) {
+    entity_view *direct = world_direct_view_get(entity_id);
+    if (direct) {
+        return *direct;
+    }
+    return entity_view_unpack_struct(pkt_ctx_local(), buffer, actual_length);
+}
+
+STREAMER_READ_PROC(tracker_read_remove) {
+    (void)buffer;
+    (void)length;
+    world_view *view = (world_view*)userdata;
     entity_view *ent = entity_view_get(&view->entities, entity_id);
 
     if (ent && ent->kind == EKIND_CHUNK) {
@@ -22,16 +33,16 @@ int32_t tracker_read_remove(librg_world *w, librg_event *e) {
     return 0;
 }
 
-int32_t tracker_read_update(librg_world *w, librg_event *e) {
-    int64_t entity_id = librg_event_entity_get(w, e);
-    size_t actual_length = librg_event_size_get(w, e);
-    char *buffer = librg_event_buffer_get(w, e);
-    world_view *view = (world_view*)librg_world_userdata_get(w);
+STREAMER_READ_PROC(tracker_read_update) {
+    world_view *view = (world_view*)userdata;
 
-    entity_view data = entity_view_unpack_struct(buffer, actual_length);
+    entity_view data = tracker_read_entity_view(entity_id, buffer, length);
     entity_view *d = entity_view_get(&view->entities, entity_id);
+
+    // NOTE(zaklaus): never saw its create or it's gone already, don't resurrect it
+    if (!d) return 0;
 #if 1
-    if (d && d->layer_id < view->active_layer_id) {
+    if (d->layer_id < view->active_layer_id) {
         if ((get_cached_time()*1000.0f) - d->last_update > WORLD_TRACKER_UPDATE_NORMAL_MS) {
             d->layer_id = zpl_min(WORLD_TRACKER_LAYERS-1, d->layer_id+1);
         }
@@ -54,13 +65,10 @@ int32_t tracker_read_update(librg_world *w, librg_event *e) {
     return 0;
 }
 
-int32_t tracker_read_create(librg_world *w, librg_event *e) {
-    int64_t entity_id = librg_event_entity_get(w, e);
-    size_t actual_length = librg_event_size_get(w, e);
-    char *buffer = librg_event_buffer_get(w, e);
-    world_view *view = (world_view*)librg_world_userdata_get(w);
+STREAMER_READ_PROC(tracker_read_create) {
+    world_view *view = (world_view*)userdata;
 
-    entity_view data = entity_view_unpack_struct(buffer, actual_length);
+    entity_view data = tracker_read_entity_view(entity_id, buffer, length);
     data.ent_id = entity_id;
     data.layer_id = view->active_layer_id;
     data.tran_time = 0.0f;
@@ -104,11 +112,10 @@ void world_view_init(world_view *view, uint32_t seed, uint64_t ent_id, uint16_t
     librg_config_chunksize_set(view->tracker, WORLD_BLOCK_SIZE * chunk_size, WORLD_BLOCK_SIZE * chunk_size, 1);
     librg_config_chunkamount_set(view->tracker, chunk_amount, chunk_amount, 0);
     librg_config_chunkoffset_set(view->tracker, LIBRG_OFFSET_BEG, LIBRG_OFFSET_BEG, LIBRG_OFFSET_BEG);
+}
 
-    librg_event_set(view->tracker, LIBRG_READ_CREATE, tracker_read_create);
-    librg_event_set(view->tracker, LIBRG_READ_REMOVE, tracker_read_remove);
-    librg_event_set(view->tracker, LIBRG_READ_UPDATE, tracker_read_update);
-    librg_world_userdata_set(view->tracker, view);
+int32_t world_view_read(world_view *view, void *data, size_t datalen) {
+    return streamer_read((char*)data, datalen, view, tracker_read_create, tracker_read_update, tracker_read_remove);
 }
 
 void world_view_destroy(world_view *view) {
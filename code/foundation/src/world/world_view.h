@@ -29,6 +29,9 @@ world_view world_view_create(uint16_t view_id);
 void world_view_init(world_view *view, uint32_t seed, uint64_t ent_id, uint16_t chunk_size, uint16_t chunk_amount);
 void world_view_destroy(world_view *view);
 
+// NOTE(zaklaus): applies a world stream, entity ids are connection-scoped handles when the server uses them
+int32_t world_view_read(world_view *view, void *data, size_t datalen);
+
 void world_view_setup_chunk(world_view *view, entity_view *chk);
 void world_view_clear_chunk(world_view *view, entity_view *chk);
 
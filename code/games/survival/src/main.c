@@ -8,6 +8,8 @@
 #include "utils/options.h"
 #include "platform/signal_handling.h"
 #include "platform/profiler.h"
+#include "net/network.h"
+#include "world/region.h"
 
 #include "flecs.h"
 #include "flecs/flecs_os_api_stdcpp.h"
@@ -54,6 +56,16 @@ int main(int argc, char** argv) {
     zpl_opts_add(&opts, "ws", "world-size", "amount of chunks within a world (single axis)", ZPL_OPTS_INT);
     zpl_opts_add(&opts, "ip", "host", "host IP address", ZPL_OPTS_STRING);
     zpl_opts_add(&opts, "port", "port", "port number", ZPL_OPTS_INT);
+    zpl_opts_add(&opts, "mp", "max-peers", "maximum amount of connected peers (server only)", ZPL_OPTS_INT);
+    zpl_opts_add(&opts, "ch", "channels", "amount of network channels", ZPL_OPTS_INT);
+    zpl_opts_add(&opts, "b", "bots", "run N windowless bots against a server at --host/--port, loopback by default", ZPL_OPTS_INT);
+    zpl_opts_add(&opts, "bs", "bot-script", "bots walk a scripted path instead of a random one", ZPL_OPTS_FLAG);
+    zpl_opts_add(&opts, "ns", "net-stats", "dump per-peer network stats every second into a file, - for stdout (server only)", ZPL_OPTS_STRING);
+    zpl_opts_add(&opts, "nsf", "net-stats-format", "network stats format: csv or json", ZPL_OPTS_STRING);
+    zpl_opts_add(&opts, "rg", "regions", "split the world into NxN regions and report border crossings (server only)", ZPL_OPTS_INT);
+    zpl_opts_add(&opts, "th", "threads", "amount of worker threads running the simulation systems", ZPL_OPTS_INT);
+    zpl_opts_add(&opts, "sr", "sim-rate", "fixed simulation steps per second, 0 steps once per frame (server only)", ZPL_OPTS_INT);
+    zpl_opts_add(&opts, "ss", "sim-substeps", "maximum amount of simulation steps to catch up on per frame", ZPL_OPTS_INT);
 
     uint32_t ok = zpl_opts_compile(&opts, argc, argv);
 
@@ -71,11 +83,15 @@ int main(int argc, char** argv) {
     uint16_t chunk_size = DEFAULT_CHUNK_SIZE; //zpl_opts_integer(&opts, "chunk-size", DEFAULT_CHUNK_SIZE);
     zpl_string host = zpl_opts_string(&opts, "host", NULL);
     uint16_t port = (uint16_t)zpl_opts_integer(&opts, "port", 0);
+    uint32_t max_peers = (uint32_t)zpl_opts_integer(&opts, "max-peers", NETWORK_MAX_PEERS);
+    uint32_t channels = (uint32_t)zpl_opts_integer(&opts, "channels", NETWORK_CHANNEL_COUNT);
+    uint32_t bots = (uint32_t)zpl_opts_integer(&opts, "bots", 0);
 
     game_kind play_mode = GAMEKIND_SINGLE;
 
     if (is_viewer_only) play_mode = GAMEKIND_CLIENT;
     if (is_server_only) play_mode = GAMEKIND_HEADLESS;
+    if (bots > 0) play_mode = GAMEKIND_BOTS;
 
     if (zpl_opts_has_arg(&opts, "random-seed")) {
         zpl_random rnd={0};
@@ -90,7 +106,19 @@ int main(int argc, char** argv) {
     }
 
     sighandler_register();
+    network_setup(max_peers, channels);
+    region_setup((uint16_t)zpl_opts_integer(&opts, "regions", 1), (uint16_t)zpl_opts_integer(&opts, "regions", 1));
+    systems_setup_threads((uint32_t)zpl_opts_integer(&opts, "threads", 1));
+    world_setup_sim_rate((uint16_t)zpl_opts_integer(&opts, "sim-rate", WORLD_SIM_DEFAULT_RATE), (uint8_t)zpl_opts_integer(&opts, "sim-substeps", WORLD_SIM_DEFAULT_SUBSTEPS));
+    if (zpl_opts_has_arg(&opts, "net-stats")) {
+        zpl_string stats_format = zpl_opts_string(&opts, "net-stats-format", "csv");
+        network_server_stats_setup(zpl_opts_string(&opts, "net-stats", "-"), zpl_strcmp(stats_format, "json") ? NETWORK_STATS_CSV : NETWORK_STATS_JSON);
+    }
     game_setup(host, port, play_mode, 1, seed, chunk_size, world_size, is_dash_enabled);
+
+    if (bots > 0) {
+        network_bots_start(bots, zpl_opts_has_arg(&opts, "bot-script"), host ? host : "127.0.0.1", port > 0 ? port : 27000);
+    }
     game_run();
 
     game_shutdown();
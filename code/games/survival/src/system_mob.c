@@ -125,7 +125,7 @@ void MobOnDead(ecs_iter_t *it) {
 		++mob_kills;
 		recalc_max_mobs();
 
-		pkt_code_send(0, 0, (pkt_send_code){
+		pkt_code_send(pkt_ctx_local(), 0, 0, (pkt_send_code){
 			.code = SURV_CODE_SHOW_NOTIF,
 			.data = "mob died"
 		});
@@ -1,7 +1,3 @@
-ZPL_DIAGNOSTIC_PUSH_WARNLEVEL(0)
-#include "tinyc2.h"
-ZPL_DIAGNOSTIC_POP
-
 #define WEAPON_KNIFE_SPAWN_DELAY 20
 #define WEAPON_PROJECTILE_POS_OFFSET 200.0f
 #define WEAPON_PROJECTILE_SPEED 500.0f
@@ -20,6 +16,14 @@ void WeaponKnifeMechanic(ecs_iter_t* it) {
         }
 
         for (int j = 0; j < weapon[i].projectile_count; j++) {
+            zpl_vec2 input_vec = {
+                .x = input[i].hy,
+                .y = input[i].hx
+            };
+
+            zpl_vec2 pos_offset;
+            zpl_vec2_mul(&pos_offset, input_vec, get_rand_between(-WEAPON_PROJECTILE_POS_OFFSET, WEAPON_PROJECTILE_POS_OFFSET));
+
             ecs_entity_t e = entity_spawn(EKIND_WEAPON);
             ecs_set(it->world, e, Sprite, { .spritesheet = 0, .frame = 2347 });
             ecs_set(it->world, e, TriggerOnly, { 0 });
@@ -27,6 +31,8 @@ void WeaponKnifeMechanic(ecs_iter_t* it) {
                 .damage = weapon[i].damage,
                 .origin_x = pos[i].x,
                 .origin_y = pos[i].y,
+                .last_x = pos[i].x + pos_offset.x,
+                .last_y = pos[i].y + pos_offset.y,
                 .owner = it->entities[i]
                 });
 			ecs_set(it->world, e, StreamLayerOverride, { .layer = 0 });
@@ -40,13 +46,6 @@ void WeaponKnifeMechanic(ecs_iter_t* it) {
                 .y = input[i].hy * WEAPON_PROJECTILE_SPEED * -1
                 });
 
-            zpl_vec2 input_vec = {
-                .x = input[i].hy,
-                .y = input[i].hx
-            };
-
-            zpl_vec2 pos_offset;
-            zpl_vec2_mul(&pos_offset, input_vec, get_rand_between(-WEAPON_PROJECTILE_POS_OFFSET, WEAPON_PROJECTILE_POS_OFFSET));
             Position* dest = ecs_get_mut(world_ecs(), e, Position);
             dest->x = pos[i].x + pos_offset.x;
             dest->y = pos[i].y + pos_offset.y;
@@ -80,64 +79,68 @@ zpl_vec2 rotate_point(float cx, float cy, float angle, zpl_vec2 p) {
     };
 }
 
+// NOTE(zaklaus): projectiles are swept from where the previous test left off, so they can't skip
+// over a target or a wall in between two ticks, no matter how fast they go
 void WeaponProjectileHit(ecs_iter_t* it) {
-    const WeaponProjectile* weapon = ecs_field(it, WeaponProjectile, 1);
+    WeaponProjectile* weapon = ecs_field(it, WeaponProjectile, 1);
     const Position* pos = ecs_field(it, Position, 2);
-    const Rotation* rot = ecs_field(it, Rotation, 3);
 
     for (int i = 0; i < it->count; i++) {
+        float x0 = weapon[i].last_x;
+        float y0 = weapon[i].last_y;
+        float dx = pos[i].x - x0;
+        float dy = pos[i].y - y0;
+        weapon[i].last_x = pos[i].x;
+        weapon[i].last_y = pos[i].y;
+
+        float wall_toi = 1.0f;
+        bool hit_wall = systems_sweep_blocks(x0, y0, x0 + dx, y0 + dy, &wall_toi);
+
+        // NOTE(zaklaus): same targets and boxes as the old overlap test, any living pawn and two
+        // WORLD_BLOCK_SIZE/4 squares, only swept along the flight path up to the wall
+        ecs_entity_t target = 0;
+        float toi = 1.0f;
         ecs_iter_t it2 = ecs_query_iter(it->world, ecs_pawn_query);
         while (ecs_query_next(&it2)) {
             Position* pawn_pos = ecs_field(&it2, Position, 1);
-			Health *pawn_health = ecs_field(&it2, Health, 2);
-			Velocity *pawn_velocity = ecs_field(&it2, Velocity, 3);
 
             for (int j = 0; j < it2.count; j++) {
-                if (weapon[i].owner == it2.entities[j]) 
+                if (weapon[i].owner == it2.entities[j])
                     continue;
 
-                float p_x = pos[i].x;
-                float p_y = pos[i].y;
-                float p2_x = pawn_pos[j].x /*+ v2[j].x*/;
-                float p2_y = pawn_pos[j].y /*+ v2[j].y*/;
-
-                c2AABB box_a = {
-					.min = { p_x - WORLD_BLOCK_SIZE / 4 , p_y - WORLD_BLOCK_SIZE / 4 },
-					.max = { p_x + WORLD_BLOCK_SIZE / 4 , p_y + WORLD_BLOCK_SIZE / 4 },
-                };
-
-                c2AABB box_b = {
-                    .min = { p2_x - WORLD_BLOCK_SIZE / 4, p2_y - WORLD_BLOCK_SIZE / 4 },
-                    .max = { p2_x + WORLD_BLOCK_SIZE / 4, p2_y + WORLD_BLOCK_SIZE / 4 },
-                };
-
-                float r1x = (box_a.max.x - box_a.min.x);
-                float r1y = (box_a.max.y - box_a.min.y);
-                float r1 = (r1x * r1x + r1y * r1y) * .5f;
-
-                float r2x = (box_b.max.x - box_b.min.x);
-                float r2y = (box_b.max.y - box_b.min.y);
-                float r2 = (r2x * r2x + r2y * r2y) * .5f;
-
-				float dx = (p2_x - p_x);
-				float dy = (p2_y - p_y);
-				float d2 = (dx * dx + dy * dy);
-				{
-
-					if (d2 > r1 && d2 > r2)
-						continue;
-				}
-
+                float t;
+                if (!physics_segment_aabb(dx*wall_toi, dy*wall_toi, pawn_pos[j].x - x0, pawn_pos[j].y - y0,
+                                          WORLD_BLOCK_SIZE / 2, WORLD_BLOCK_SIZE / 2, &t))
+                    continue;
+                if (t > toi || (target && t == toi))
+                    continue;
 
-				if (c2AABBtoAABB(box_a, box_b)) {
-					float dd = zpl_sqrt(d2);
-					pawn_health[j].dmg += weapon[i].damage;
+                target = it2.entities[j];
+                toi = t;
+            }
+        }
 
-					pawn_velocity[j].x += (dx/dd)*WEAPON_HIT_FORCE_PUSH;
-					pawn_velocity[j].y += (dy/dd)*WEAPON_HIT_FORCE_PUSH;
-                    entity_despawn(it->entities[i]);
-                }
+        if (target) {
+            const Position *target_pos = ecs_get(it->world, target, Position);
+            Health *target_health = ecs_get_mut(it->world, target, Health);
+            Velocity *target_velocity = ecs_get_mut(it->world, target, Velocity);
+
+            // NOTE(zaklaus): push away from the point of impact, along the flight path if we hit dead center
+            float hx = target_pos->x - (x0 + dx*wall_toi*toi);
+            float hy = target_pos->y - (y0 + dy*wall_toi*toi);
+            float hd = zpl_sqrt(hx*hx + hy*hy);
+            if (hd == 0.0f) {
+                hx = dx; hy = dy;
+                hd = zpl_max(zpl_sqrt(dx*dx + dy*dy), 1.0f);
             }
+
+            target_health->dmg += weapon[i].damage;
+            target_velocity->x += (hx/hd)*WEAPON_HIT_FORCE_PUSH;
+            target_velocity->y += (hy/hd)*WEAPON_HIT_FORCE_PUSH;
+            entity_wake(target);
+            entity_despawn(it->entities[i]);
+        } else if (hit_wall) {
+            entity_despawn(it->entities[i]);
         }
     }
 }